@@ -19,6 +19,10 @@
  * - Preserves non-alphabetic characters
  * - Efficient string processing with likely/unlikely attributes
  * - Automatic case normalization (converts to lowercase)
+ * - Allocation-free: exact output size computed up front, digits
+ *   emitted and parsed directly
+ * - SIMD encode/decode kernels, the scalar loop finishing the tail
+ *   (see Simd.hpp)
  * 
  * @author CipherSuite Team
  * @version 1.0
@@ -27,59 +31,149 @@
 
 #pragma once
 #include "Encryptions.hpp"
-#include<cctype>
-#include<string>
+#include "SubstitutionTable.hpp"
 
 
 class A1Z26 final: public Encryption {
     public:
-        void encrypt() override{
-            for (const char c : message) {
-                if (isalpha(c)) {
-                    encrypted_message += encryptChar(c);
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "a1z26";
+        }
+
+        [[nodiscard]] bool preservesLength() const noexcept override{
+            return false;
+        }
+
+        /**
+         * Letters become two digits when encrypting, and up to two digits
+         * when decrypting
+         */
+        [[nodiscard]] std::size_t maxTransformedSize(const std::size_t n, Direction) const noexcept override{
+            return 2 * n;
+        }
+
+        /**
+         * Exact size: one extra byte per letter when encrypting; when
+         * decrypting, digit pairs shrink to one byte and letters j-z grow
+         * to two digits
+         */
+        [[nodiscard]] std::size_t transformedSize(const std::span<const char> in, const Direction d, std::size_t = 0) const noexcept override{
+            std::size_t size = 0;
+            if (d == Direction::encrypt) {
+                const std::size_t done = countLetters(in, size, simd_level);
+                size += in.size();
+                for (const char c : in.subspan(done)) {
+                    size += isLetter(c);
                 }
-                else if (isdigit(c)) {
-                    encrypted_message += c + 48;
+                return size;
+            }
+            std::size_t i = measureA1z26Decode(in, size, simd_level);
+            size += in.size() - i;
+            for (; i < in.size(); ++i) {
+                if (isDigitAscii(in[i])) {
+                    size -= i + 1 < in.size();
+                    ++i;
                 }
-                else {
-                    encrypted_message += c;
+                else if (isLetter(in[i])) {
+                    size += letterIndex(in[i]) >= 10;
                 }
             }
+            return size;
+        }
+
+        /**
+         * A digit starts a two-character group when decrypting, so a chunk
+         * must not end on the first half of one. Groups restart after any
+         * non-digit (see splitPoint()), so only the trailing run of digits
+         * is looked at: an odd run ends on a lone first half.
+         */
+        [[nodiscard]] std::size_t completeLength(const std::string_view input, const Direction d) const noexcept override{
+            if (d == Direction::encrypt) {
+                return input.size();
+            }
+            std::size_t run = 0;
+            while (run < input.size() and isDigitAscii(input[input.size() - 1 - run])) {
+                ++run;
+            }
+            return input.size() - run % 2;
         }
 
         /**
-         * Decrypts A1Z26 encoded message back to plaintext
-         * Converts numbers back to letters and letters to numbers
+         * Decryption groups never straddle a position whose predecessor is
+         * a non-digit, so any such position is a safe cut
          */
-        void decrypt() override{
-            for (int i = 0; i < message.size(); ++i) {
-                if (isdigit(message[i])) [[likely]] {
-                    // Extract 2-digit number and convert to letter
-                    const std::string num_str = message.substr(i++, 2);
-                    const int num = std::stoi(num_str);
-                    encrypted_message += char('a' + num - 1); // Convert 1-based to 0-based
+        [[nodiscard]] std::size_t splitPoint(const std::span<const char> in, std::size_t hint, const Direction d) const noexcept override{
+            if (d == Direction::encrypt or hint >= in.size()) {
+                return std::min(hint, in.size());
+            }
+            while (hint > 0 and hint < in.size() and isDigitAscii(in[hint - 1])) {
+                ++hint;
+            }
+            return hint;
+        }
+
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, std::size_t) const noexcept override{
+            std::size_t written = 0;
+            if (d == Direction::encrypt) {
+                const std::size_t done = encodeA1z26(in, out, written, simd_level);
+                char* dst = out.data() + written;
+                for (const char c : in.subspan(done)) {
+                    if (isLetter(c)) {
+                        // Zero-padded two-digit position
+                        const int index = letterIndex(c);
+                        *dst++ = static_cast<char>('0' + index / 10);
+                        *dst++ = static_cast<char>('0' + index % 10);
+                    }
+                    else if (isDigitAscii(c)) {
+                        *dst++ = static_cast<char>(c + 48);
+                    }
+                    else {
+                        *dst++ = c;
+                    }
                 }
-                else if (isalpha(message[i])) {
-                    // Convert letter to its 1-based position
-                    encrypted_message += std::to_string(tolower(message[i]) - 96);
+                return static_cast<std::size_t>(dst - out.data());
+            }
+
+            std::size_t i = decodeA1z26(in, out, written, simd_level);
+            char* dst = out.data() + written;
+            for (; i < in.size(); ++i) {
+                const char c = in[i];
+                if (isDigitAscii(c)) [[likely]] {
+                    // A digit and the character after it form one group;
+                    // the second only counts if it is a digit too
+                    int num = c - '0';
+                    if (i + 1 < in.size() and isDigitAscii(in[i + 1])) {
+                        num = num * 10 + (in[i + 1] - '0');
+                    }
+                    ++i;
+                    *dst++ = static_cast<char>('a' + num - 1); // Convert 1-based to 0-based
                 }
-                else 
+                else if (isLetter(c)) {
+                    // Convert letter to its 1-based position, unpadded
+                    const int index = letterIndex(c);
+                    if (index >= 10) {
+                        *dst++ = static_cast<char>('0' + index / 10);
+                    }
+                    *dst++ = static_cast<char>('0' + index % 10);
+                }
+                else
                 {
                     // Preserve non-alphabetic characters
-                    encrypted_message += message[i];
+                    *dst++ = c;
                 }
             }
+            return static_cast<std::size_t>(dst - out.data());
         }
 
     private:
-        [[nodiscard]] static std::string encryptChar(char c) noexcept{
-            c = tolower(c);
-            c -= 96;
-            if (c < 10) [[unlikely]] {
-                return '0' + std::to_string(c);
-            }
-            else [[likely]] {
-                return std::to_string(c);
-            }
+        [[nodiscard]] static constexpr bool isLetter(const char c) noexcept{
+            return isUpperAscii(c) or isLowerAscii(c);
+        }
+
+        /**
+         * 1-based alphabet position of an ASCII letter, ignoring case
+         */
+        [[nodiscard]] static constexpr int letterIndex(const char c) noexcept{
+            return (c | 0x20) - 'a' + 1;
         }
 };
\ No newline at end of file
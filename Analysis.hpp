@@ -0,0 +1,209 @@
+/**
+ * @file Analysis.hpp
+ * @brief Frequency-Analysis Key Recovery for Caesar and Vigenère
+ *
+ * Recovers lost keys from ciphertext alone, assuming English plaintext.
+ * Nothing is ever decrypted: one vectorized pass classifies every byte
+ * into its letter index (Simd.hpp letterIndices()), and everything else
+ * is computed from letter histograms.
+ *
+ * - Caesar: chi-squared of the letter histogram against English for each
+ *   of the 26 shifts; the best fit is the key
+ * - Vigenère: for every candidate key length L, per-column histograms
+ *   (column = byte position mod L, matching the key schedule, which
+ *   advances on every byte) give the mean index of coincidence; each
+ *   length is scored on its own thread. The shortest length scoring
+ *   close to the best wins, and each of its columns is solved like a
+ *   Caesar cipher.
+ *
+ * Accuracy grows with text length: a few hundred letters per key
+ * character is comfortable, a few dozen is marginal.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include<algorithm>
+#include<array>
+#include<cstddef>
+#include<limits>
+#include<span>
+#include<string>
+#include<vector>
+
+
+using LetterHistogram = std::array<std::size_t, 26>;
+
+/**
+ * Relative letter frequencies of English text, A..Z
+ */
+inline constexpr std::array<double, 26> ENGLISH_FREQUENCIES = {
+    0.08167, 0.01492, 0.02782, 0.04253, 0.12702, 0.02228, 0.02015, 0.06094, 0.06966,
+    0.00153, 0.00772, 0.04025, 0.02406, 0.06749, 0.07507, 0.01929, 0.00095, 0.05987,
+    0.06327, 0.09056, 0.02758, 0.00978, 0.02360, 0.00150, 0.01974, 0.00074,
+};
+
+/**
+ * Index of coincidence of uniformly random letters (1/26); English text
+ * sits near 0.066
+ */
+inline constexpr double RANDOM_COINCIDENCE = 1.0 / 26.0;
+
+struct CaesarGuess {
+    int key = 0;                // shift for Caesar::setKey()
+    double chi_squared = 0.0;   // fit of the decryption against English
+};
+
+struct VigenereGuess {
+    std::string key;                    // keyword for Vigenere::setKeyMessage()
+    double chi_squared = 0.0;           // summed over the key's columns
+    double index_of_coincidence = 0.0;  // mean over the key's columns
+};
+
+/**
+ * Letter index (0..25, case folded) of every byte, 0xFF for non-letters
+ */
+[[nodiscard]] inline std::vector<unsigned char> letterIndices(const std::span<const char> text, const SimdLevel level = bestSimdLevel()) {
+    std::vector<unsigned char> indices(text.size());
+    std::size_t i = letterIndices(text, indices.data(), level);
+    for (; i < text.size(); ++i) {
+        const unsigned char idx = static_cast<unsigned char>((static_cast<unsigned char>(text[i]) & ~0x20u) - 'A');
+        indices[i] = idx < 26 ? idx : 0xFF;
+    }
+    return indices;
+}
+
+/**
+ * Chi-squared distance from English of the text obtained by shifting
+ * every letter in histogram back by shift
+ */
+[[nodiscard]] inline double chiSquared(const LetterHistogram& histogram, const int shift) noexcept{
+    std::size_t total = 0;
+    for (const std::size_t count : histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    double score = 0.0;
+    for (int letter = 0; letter < 26; ++letter) {
+        const double expected = ENGLISH_FREQUENCIES[letter] * static_cast<double>(total);
+        const double observed = static_cast<double>(histogram[(letter + shift) % 26]);
+        score += (observed - expected) * (observed - expected) / expected;
+    }
+    return score;
+}
+
+/**
+ * Probability that two letters drawn from histogram match
+ */
+[[nodiscard]] inline double indexOfCoincidence(const LetterHistogram& histogram) noexcept{
+    std::size_t total = 0;
+    double pairs = 0.0;
+    for (const std::size_t count : histogram) {
+        total += count;
+        pairs += static_cast<double>(count) * static_cast<double>(count > 0 ? count - 1 : 0);
+    }
+    return total < 2 ? 0.0 : pairs / (static_cast<double>(total) * static_cast<double>(total - 1));
+}
+
+/**
+ * Shift (0..25) that makes histogram look most like English
+ */
+[[nodiscard]] inline CaesarGuess bestShift(const LetterHistogram& histogram) noexcept{
+    CaesarGuess best{0, std::numeric_limits<double>::infinity()};
+    for (int shift = 0; shift < 26; ++shift) {
+        const double score = chiSquared(histogram, shift);
+        if (score < best.chi_squared) {
+            best = {shift, score};
+        }
+    }
+    return best;
+}
+
+/**
+ * Per-column letter histograms for key length columns
+ * @param indices Output of letterIndices()
+ */
+[[nodiscard]] inline std::vector<LetterHistogram> columnHistograms(const std::span<const unsigned char> indices, const std::size_t columns) {
+    std::vector<LetterHistogram> histograms(columns, LetterHistogram{});
+    std::size_t column = 0;
+    for (const unsigned char idx : indices) {
+        if (idx < 26) {
+            ++histograms[column][idx];
+        }
+        if (++column == columns) {
+            column = 0;
+        }
+    }
+    return histograms;
+}
+
+/**
+ * Recovers a Caesar shift from ciphertext
+ */
+[[nodiscard]] inline CaesarGuess crackCaesar(const std::span<const char> ciphertext) {
+    return bestShift(columnHistograms(letterIndices(ciphertext), 1)[0]);
+}
+
+/**
+ * Recovers a Vigenère keyword from ciphertext
+ * @param max_key_length Longest key length tried; lengths that leave
+ *                       fewer than a handful of letters per column are
+ *                       skipped
+ * @param pool Threads that score candidate lengths
+ */
+[[nodiscard]] inline VigenereGuess crackVigenere(const std::span<const char> ciphertext, const std::size_t max_key_length = 32, ThreadPool& pool = sharedThreadPool()) {
+    constexpr std::size_t MIN_LETTERS_PER_COLUMN = 8;
+    const std::vector<unsigned char> indices = letterIndices(ciphertext);
+    std::size_t letters = 0;
+    for (const unsigned char idx : indices) {
+        letters += idx < 26;
+    }
+    const std::size_t longest = std::max<std::size_t>(1, std::min(max_key_length, letters / MIN_LETTERS_PER_COLUMN));
+
+    std::vector<std::vector<LetterHistogram>> histograms(longest + 1);
+    std::vector<double> coincidence(longest + 1, 0.0);
+    pool.parallelFor(longest, [&](const std::size_t i) {
+        const std::size_t length = i + 1;
+        histograms[length] = columnHistograms(indices, length);
+        double sum = 0.0;
+        for (const LetterHistogram& column : histograms[length]) {
+            sum += indexOfCoincidence(column);
+        }
+        coincidence[length] = sum / static_cast<double>(length);
+    });
+
+    // Multiples of the true length score as well as it does, so take the
+    // shortest length that gets most of the way to the best score
+    double best = 0.0;
+    for (std::size_t length = 1; length <= longest; ++length) {
+        best = std::max(best, coincidence[length]);
+    }
+    std::size_t chosen = 1;
+    while (chosen < longest and coincidence[chosen] - RANDOM_COINCIDENCE < 0.9 * (best - RANDOM_COINCIDENCE)) {
+        ++chosen;
+    }
+
+    VigenereGuess guess;
+    guess.index_of_coincidence = coincidence[chosen];
+    for (const LetterHistogram& column : histograms[chosen]) {
+        const CaesarGuess shift = bestShift(column);
+        // Vigenère shifts by the key letter's 1-based index, so Z is 0
+        guess.key += static_cast<char>('A' + (shift.key + 25) % 26);
+        guess.chi_squared += shift.chi_squared;
+    }
+
+    // A repeating key (ABAB) is the same cipher as its period (AB)
+    for (std::size_t period = 1; period < guess.key.size(); ++period) {
+        if (guess.key.size() % period == 0 and guess.key.compare(period, std::string::npos, guess.key, 0, guess.key.size() - period) == 0) {
+            guess.key.resize(period);
+            break;
+        }
+    }
+    return guess;
+}
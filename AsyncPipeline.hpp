@@ -0,0 +1,567 @@
+/**
+ * @file AsyncPipeline.hpp
+ * @brief Overlapped Read / Transform / Write Pipeline
+ *
+ * streamTransform() runs read -> encrypt -> write one step at a time, so
+ * the disk sits idle while the cipher runs and vice versa. This driver
+ * keeps up to `depth` chunks in flight: while chunk k is transformed on
+ * the calling thread, chunk k + 1 (and further) is being read and chunk
+ * k - 1 is being written.
+ *
+ * Two I/O engines sit behind one driver:
+ * - UringEngine: Linux io_uring through the raw system calls; reads of
+ *   regular files are issued at explicit offsets, several at a time, and
+ *   submissions are batched into one io_uring_enter() per wake-up
+ * - ThreadEngine: portable POSIX fallback with one reader and one writer
+ *   thread doing blocking read()/pread()/write()
+ *
+ * Output is byte-for-byte identical to streamTransform(), including
+ * Vigenère key phase and A1Z26 digit pairs that straddle two chunks.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include "Parallel.hpp"
+#include "ThreadPool.hpp"
+#include<algorithm>
+#include<cerrno>
+#include<condition_variable>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<deque>
+#include<memory>
+#include<mutex>
+#include<optional>
+#include<span>
+#include<string_view>
+#include<vector>
+
+#if __has_include(<unistd.h>)
+#define CIPHERSUITE_HAS_POSIX_IO 1
+#include<fcntl.h>
+#include<sys/stat.h>
+#include<sys/types.h>
+#include<unistd.h>
+#else
+#define CIPHERSUITE_HAS_POSIX_IO 0
+#endif
+
+#if CIPHERSUITE_HAS_POSIX_IO and __has_include(<linux/io_uring.h>)
+#define CIPHERSUITE_HAS_IO_URING 1
+#include<atomic>
+#include<linux/io_uring.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#else
+#define CIPHERSUITE_HAS_IO_URING 0
+#endif
+
+
+/**
+ * Default bytes per pipeline chunk: large enough that one system call
+ * amortizes its cost, small enough that depth chunks stay cache-friendly
+ */
+inline constexpr std::size_t PIPELINE_CHUNK_SIZE = std::size_t{1} << 20;
+
+/**
+ * Default number of chunks in flight: one reading, one transforming, one
+ * writing, plus one read ahead
+ */
+inline constexpr unsigned PIPELINE_DEPTH = 4;
+
+enum class IoBackend { automatic, uring, threads };
+
+/**
+ * Parses a backend name: "auto", "uring" or "threads"
+ */
+[[nodiscard]] inline std::optional<IoBackend> parseIoBackend(const std::string_view name) noexcept{
+    if (name == "auto") return IoBackend::automatic;
+    if (name == "uring") return IoBackend::uring;
+    if (name == "threads") return IoBackend::threads;
+    return std::nullopt;
+}
+
+#if CIPHERSUITE_HAS_POSIX_IO
+
+/**
+ * Asynchronous read/write engine. Operations are tagged with the index of
+ * the pipeline slot that owns the buffer; an offset of -1 means "at the
+ * current file position".
+ */
+class IoEngine {
+    public:
+        struct Completion {
+            std::size_t tag;
+            long result;    // bytes transferred, or -errno
+        };
+
+        virtual ~IoEngine() = default;
+        virtual void read(std::size_t tag, int fd, char* buffer, std::size_t count, std::int64_t offset) = 0;
+        virtual void write(std::size_t tag, int fd, const char* buffer, std::size_t count, std::int64_t offset) = 0;
+
+        /**
+         * Blocks until at least one queued operation has finished
+         */
+        virtual Completion wait() = 0;
+};
+
+/**
+ * Fallback engine: ordered blocking I/O on a reader and a writer thread
+ */
+class ThreadEngine final : public IoEngine {
+    public:
+        void read(const std::size_t tag, const int fd, char* const buffer, const std::size_t count, const std::int64_t offset) override {
+            reader.submit([=, this] {
+                const ssize_t n = offset < 0 ? ::read(fd, buffer, count) : ::pread(fd, buffer, count, static_cast<off_t>(offset));
+                complete(tag, n < 0 ? -errno : static_cast<long>(n));
+            });
+        }
+
+        void write(const std::size_t tag, const int fd, const char* const buffer, const std::size_t count, const std::int64_t offset) override {
+            writer.submit([=, this] {
+                const ssize_t n = offset < 0 ? ::write(fd, buffer, count) : ::pwrite(fd, buffer, count, static_cast<off_t>(offset));
+                complete(tag, n < 0 ? -errno : static_cast<long>(n));
+            });
+        }
+
+        Completion wait() override {
+            std::unique_lock lock(mutex);
+            ready.wait(lock, [this] { return not completions.empty(); });
+            const Completion c = completions.front();
+            completions.pop_front();
+            return c;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Completion> completions;
+        // Declared last so their threads finish before the queue goes away
+        ThreadPool reader{1};
+        ThreadPool writer{1};
+
+        void complete(const std::size_t tag, const long result) {
+            {
+                const std::lock_guard lock(mutex);
+                completions.push_back({tag, result});
+            }
+            ready.notify_one();
+        }
+};
+
+#if CIPHERSUITE_HAS_IO_URING
+
+/**
+ * io_uring engine on the raw system calls (no liburing dependency)
+ */
+class UringEngine final : public IoEngine {
+    public:
+        /**
+         * @return Engine with room for entries operations in flight, or
+         *         nullptr if the kernel lacks io_uring (or IORING_OP_READ)
+         */
+        [[nodiscard]] static std::unique_ptr<UringEngine> create(const unsigned entries) {
+            auto engine = std::unique_ptr<UringEngine>(new UringEngine());
+            if (not engine->setup(entries)) {
+                return nullptr;
+            }
+            return engine;
+        }
+
+        UringEngine(const UringEngine&) = delete;
+        UringEngine& operator=(const UringEngine&) = delete;
+
+        ~UringEngine() override {
+            if (sqes != nullptr) {
+                ::munmap(sqes, sqes_bytes);
+            }
+            if (cq_ring != nullptr and cq_ring != sq_ring) {
+                ::munmap(cq_ring, cq_bytes);
+            }
+            if (sq_ring != nullptr) {
+                ::munmap(sq_ring, sq_bytes);
+            }
+            if (ring_fd >= 0) {
+                ::close(ring_fd);
+            }
+        }
+
+        void read(const std::size_t tag, const int fd, char* const buffer, const std::size_t count, const std::int64_t offset) override {
+            queue(IORING_OP_READ, tag, fd, buffer, count, offset);
+        }
+
+        void write(const std::size_t tag, const int fd, const char* const buffer, const std::size_t count, const std::int64_t offset) override {
+            queue(IORING_OP_WRITE, tag, fd, const_cast<char*>(buffer), count, offset);
+        }
+
+        Completion wait() override {
+            while (completions.empty()) {
+                const long submitted = ::syscall(__NR_io_uring_enter, ring_fd, unsubmitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (submitted < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // The ring itself is unusable; no tag identifies this
+                    return {SIZE_MAX, -errno};
+                }
+                unsubmitted -= static_cast<unsigned>(submitted);
+                reap();
+            }
+            const Completion c = completions.front();
+            completions.pop_front();
+            return c;
+        }
+
+    private:
+        int ring_fd = -1;
+        void* sq_ring = nullptr;
+        void* cq_ring = nullptr;
+        io_uring_sqe* sqes = nullptr;
+        std::size_t sq_bytes = 0;
+        std::size_t cq_bytes = 0;
+        std::size_t sqes_bytes = 0;
+        unsigned* sq_head = nullptr;
+        unsigned* sq_tail = nullptr;
+        unsigned* sq_array = nullptr;
+        unsigned sq_mask = 0;
+        unsigned sq_entries = 0;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe* cqes = nullptr;
+        unsigned unsubmitted = 0;
+        std::deque<Completion> completions;
+
+        UringEngine() = default;
+
+        template<typename T>
+        static T* at(void* const base, const std::size_t offset) noexcept{
+            return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+        }
+
+        bool setup(const unsigned entries) {
+            io_uring_params params{};
+            ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            // IORING_FEAT_RW_CUR_POS arrived with IORING_OP_READ/WRITE (5.6)
+            if (ring_fd < 0 or not (params.features & IORING_FEAT_RW_CUR_POS)) {
+                return false;
+            }
+
+            sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap) {
+                sq_bytes = cq_bytes = std::max(sq_bytes, cq_bytes);
+            }
+            sq_ring = ::mmap(nullptr, sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) {
+                sq_ring = nullptr;
+                return false;
+            }
+            cq_ring = single_mmap ? sq_ring : ::mmap(nullptr, cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                cq_ring = nullptr;
+                return false;
+            }
+            sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+            void* const sqe_map = ::mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+            if (sqe_map == MAP_FAILED) {
+                return false;
+            }
+            sqes = static_cast<io_uring_sqe*>(sqe_map);
+
+            sq_head = at<unsigned>(sq_ring, params.sq_off.head);
+            sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+            sq_entries = params.sq_entries;
+            sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+            sq_mask = *at<unsigned>(sq_ring, params.sq_off.ring_mask);
+            cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+            cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+            cq_mask = *at<unsigned>(cq_ring, params.cq_off.ring_mask);
+            cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+            return true;
+        }
+
+        /**
+         * Adds an operation to the submission ring. If the ring is unusable
+         * the operation completes at once with -errno.
+         */
+        void queue(const std::uint8_t opcode, const std::size_t tag, const int fd, char* const buffer, const std::size_t count, const std::int64_t offset) {
+            // Only this thread produces, so the tail can be read plainly;
+            // the release store publishes the entry to the kernel
+            const unsigned tail = *sq_tail;
+            while (tail - std::atomic_ref(*sq_head).load(std::memory_order_acquire) >= sq_entries) {
+                // More operations than the ring was sized for: hand the
+                // queued ones to the kernel and sleep until one finishes,
+                // keeping its completion for wait(). EBUSY means the
+                // completion ring is full, which reaping clears.
+                const long submitted = ::syscall(__NR_io_uring_enter, ring_fd, unsubmitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (submitted >= 0) {
+                    unsubmitted -= static_cast<unsigned>(submitted);
+                }
+                else if (errno != EINTR and errno != EBUSY) {
+                    completions.push_back({tag, -errno});
+                    return;
+                }
+                reap();
+            }
+            const unsigned index = tail & sq_mask;
+            io_uring_sqe& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = opcode;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+            sqe.len = static_cast<std::uint32_t>(count);
+            sqe.off = static_cast<std::uint64_t>(offset);
+            sqe.user_data = tag;
+            sq_array[index] = index;
+            std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+            ++unsubmitted;
+        }
+
+        void reap() {
+            unsigned head = *cq_head;
+            const unsigned tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & cq_mask];
+                completions.push_back({static_cast<std::size_t>(cqe.user_data), cqe.res});
+            }
+            std::atomic_ref(*cq_head).store(head, std::memory_order_release);
+        }
+};
+
+#endif
+
+/**
+ * Engine for a backend request
+ * @return nullptr if the requested backend is unavailable
+ */
+[[nodiscard]] inline std::unique_ptr<IoEngine> makeIoEngine(const IoBackend backend, const unsigned depth) {
+#if CIPHERSUITE_HAS_IO_URING
+    if (backend != IoBackend::threads) {
+        // Each slot has at most one operation in flight
+        if (auto engine = UringEngine::create(std::max(depth, 1u) * 2)) {
+            return engine;
+        }
+    }
+#endif
+    if (backend == IoBackend::uring) {
+        return nullptr;
+    }
+    return std::make_unique<ThreadEngine>();
+}
+
+/**
+ * Transforms everything readable from in_fd and writes it to out_fd with
+ * reads, the cipher and writes overlapped
+ * @param engine I/O engine; must have nothing in flight
+ * @param cipher Configured cipher
+ * @param d Encrypt or decrypt
+ * @param in_fd Source descriptor (file, pipe or socket), read until EOF
+ * @param out_fd Destination descriptor
+ * @param chunk_size Bytes per read (must be non-zero)
+ * @param depth Chunks in flight (at least 3 for full overlap)
+ * @param pool When set, each chunk is split further across these threads
+ * @return false if any read or write failed
+ */
+[[nodiscard]] inline bool pipelineTransform(IoEngine& engine, const Encryption& cipher, const Direction d, const int in_fd, const int out_fd, const std::size_t chunk_size = PIPELINE_CHUNK_SIZE, const unsigned depth = PIPELINE_DEPTH, ThreadPool* const pool = nullptr) {
+    // Regular files are read at explicit offsets so several reads can be
+    // in flight; pipes and sockets get one read at a time
+    struct stat info {};
+    const off_t start = ::lseek(in_fd, 0, SEEK_CUR);
+    const bool seekable = start >= 0 and ::fstat(in_fd, &info) == 0 and S_ISREG(info.st_mode);
+    std::int64_t read_offset = seekable ? start : -1;
+
+    // Carried bytes (A1Z26 digit pairs) are moved into the headroom in
+    // front of the next chunk so it can be transformed in one piece
+    constexpr std::size_t HEADROOM = 64;
+    enum class State { free, reading, ready, writing };
+    struct Slot {
+        std::vector<char> input;
+        std::vector<char> output;
+        std::span<const char> result;
+        std::uint64_t sequence = 0;
+        std::int64_t offset = -1;
+        std::size_t filled = 0;
+        std::size_t written = 0;
+        bool eof = false;
+        State state = State::free;
+    };
+    std::vector<Slot> slots(std::max(depth, 1u));
+
+    std::vector<char> carried;
+    std::deque<std::size_t> write_queue;
+    std::uint64_t next_read = 0;
+    std::uint64_t next_transform = 0;
+    std::optional<std::uint64_t> last_sequence;
+    std::size_t position = 0;
+    std::size_t reads_in_flight = 0;
+    bool writing = false;
+    bool failed = false;
+
+    const auto issueRead = [&](const std::size_t i) {
+        Slot& s = slots[i];
+        const std::int64_t offset = s.offset < 0 ? -1 : s.offset + static_cast<std::int64_t>(s.filled);
+        engine.read(i, in_fd, s.input.data() + HEADROOM + s.filled, chunk_size - s.filled, offset);
+        ++reads_in_flight;
+    };
+    const auto issueReads = [&] {
+        for (std::size_t i = 0; i < slots.size() and not last_sequence and not failed; ++i) {
+            if (not seekable and reads_in_flight > 0) {
+                return;
+            }
+            Slot& s = slots[i];
+            if (s.state != State::free) {
+                continue;
+            }
+            s.input.resize(HEADROOM + chunk_size);
+            s.sequence = next_read++;
+            s.offset = read_offset;
+            s.filled = 0;
+            s.written = 0;
+            s.eof = false;
+            s.state = State::reading;
+            if (seekable) {
+                read_offset += static_cast<std::int64_t>(chunk_size);
+            }
+            issueRead(i);
+        }
+    };
+    const auto issueWrite = [&] {
+        if (writing or write_queue.empty() or failed) {
+            return;
+        }
+        Slot& s = slots[write_queue.front()];
+        engine.write(write_queue.front(), out_fd, s.result.data() + s.written, s.result.size() - s.written, -1);
+        writing = true;
+    };
+    const auto transformReady = [&] {
+        for (bool progressed = true; progressed and not failed;) {
+            progressed = false;
+            for (std::size_t i = 0; i < slots.size(); ++i) {
+                Slot& s = slots[i];
+                if (s.state != State::ready or s.sequence != next_transform) {
+                    continue;
+                }
+                progressed = true;
+                ++next_transform;
+                if (s.eof) {
+                    last_sequence = s.sequence;
+                }
+
+                std::span<char> chunk;
+                if (carried.size() <= HEADROOM) {
+                    chunk = {s.input.data() + HEADROOM - carried.size(), carried.size() + s.filled};
+                    std::copy(carried.begin(), carried.end(), chunk.begin());
+                }
+                else {
+                    // Larger carries rebuild the buffer; issueReads() sizes
+                    // it back when the slot is reused
+                    s.input.erase(s.input.begin(), s.input.begin() + HEADROOM);
+                    s.input.resize(s.filled);
+                    s.input.insert(s.input.begin(), carried.begin(), carried.end());
+                    chunk = s.input;
+                }
+                const std::size_t usable = s.eof ? chunk.size() : cipher.completeLength({chunk.data(), chunk.size()}, d);
+                const std::span<char> piece = chunk.first(usable);
+                carried.assign(chunk.begin() + static_cast<std::ptrdiff_t>(usable), chunk.end());
+
+                if (cipher.preservesLength()) {
+                    if (pool != nullptr) {
+                        parallelTransform(cipher, piece, piece, d, position, *pool);
+                    }
+                    else {
+                        cipher.transformInPlace(piece, d, position);
+                    }
+                    s.result = piece;
+                }
+                else {
+                    s.output.resize(cipher.maxTransformedSize(usable, d));
+                    const std::size_t n = pool != nullptr ? parallelTransform(cipher, piece, s.output, d, position, *pool) : cipher.transform(piece, s.output, d, position);
+                    s.result = {s.output.data(), n};
+                }
+                position += usable;
+
+                if (s.result.empty()) {
+                    s.state = State::free;
+                }
+                else {
+                    s.state = State::writing;
+                    write_queue.push_back(i);
+                }
+            }
+        }
+        // Chunks read past EOF carry nothing
+        for (Slot& s : slots) {
+            if (last_sequence and s.state == State::ready and s.sequence > *last_sequence) {
+                s.state = State::free;
+            }
+        }
+    };
+
+    issueReads();
+    while (reads_in_flight > 0 or writing) {
+        // Time blocked here is the I/O the transform could not hide
+        stats::IoTimer wait_timer;
+        const IoEngine::Completion c = engine.wait();
+        if (c.tag >= slots.size()) {
+            return false;
+        }
+        Slot& s = slots[c.tag];
+        wait_timer.record(s.state == State::reading ? stats::IoOp::read : stats::IoOp::write, static_cast<std::size_t>(std::max(c.result, 0L)));
+        if (s.state == State::reading) {
+            --reads_in_flight;
+            if (c.result == -EINTR or c.result == -EAGAIN) {
+                issueRead(c.tag);
+                continue;
+            }
+            if (c.result < 0) {
+                failed = true;
+                s.state = State::free;
+                continue;
+            }
+            s.filled += static_cast<std::size_t>(c.result);
+            s.eof = c.result == 0;
+            // Short reads of a regular file are retried to keep chunks
+            // aligned with their offsets
+            if (seekable and not s.eof and s.filled < chunk_size) {
+                issueRead(c.tag);
+                continue;
+            }
+            s.state = (last_sequence and s.sequence > *last_sequence) ? State::free : State::ready;
+        }
+        else {
+            writing = false;
+            if (c.result < 0 and c.result != -EINTR and c.result != -EAGAIN) {
+                failed = true;
+                continue;
+            }
+            s.written += static_cast<std::size_t>(std::max(c.result, 0L));
+            if (s.written == s.result.size()) {
+                s.state = State::free;
+                write_queue.pop_front();
+            }
+        }
+        transformReady();
+        issueReads();
+        issueWrite();
+    }
+    return not failed and last_sequence.has_value() and write_queue.empty();
+}
+
+/**
+ * Convenience overload that picks the engine
+ * @param backend I/O engine; automatic prefers io_uring
+ * @return false if the backend is unavailable or any read/write failed
+ */
+[[nodiscard]] inline bool pipelineTransform(const Encryption& cipher, const Direction d, const int in_fd, const int out_fd, const std::size_t chunk_size = PIPELINE_CHUNK_SIZE, const unsigned depth = PIPELINE_DEPTH, const IoBackend backend = IoBackend::automatic, ThreadPool* const pool = nullptr) {
+    const std::unique_ptr<IoEngine> engine = makeIoEngine(backend, depth);
+    return engine and pipelineTransform(*engine, cipher, d, in_fd, out_fd, chunk_size, depth, pool);
+}
+
+#endif
@@ -19,6 +19,8 @@
  * - Non-alphabetic character preservation
  * - Simple mathematical mapping
  * - Efficient implementation with direct character arithmetic
+ * - Compile-time translation table, one lookup per byte
+ * - SIMD kernel for whole vectors, table for the tail (see Simd.hpp)
  * 
  * @author CipherSuite Team
  * @version 1.0
@@ -27,34 +29,33 @@
 
 #pragma once
 #include "Encryptions.hpp"
+#include "SubstitutionTable.hpp"
 
 
+/**
+ * Reverse-alphabet mapping for a single character (A<->Z, b<->y, ...)
+ */
+[[nodiscard]] constexpr char atbashChar(const char c) noexcept{
+    if (isUpperAscii(c)) {
+        return 90 - (c - 65);
+    } 
+    else if (isLowerAscii(c)) {
+        return 122 - (c - 97);
+    }
+    return c;
+}
+
+inline constexpr SubstitutionTable ATBASH_TABLE = makeTable(atbashChar);
+
 class Atbash final: public Encryption {
     public:
-        void encrypt() override{
-            for (const char c : message) {
-                if (isalpha(c)) {
-                    encrypted_message += encryptChar(c);
-                }
-                else {
-                    encrypted_message += c;
-                }
-            }
-        }
-
-        void decrypt() override{
-            encrypt();
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "atbash";
         }
-    
 
-    private:
-        [[nodiscard]] static char encryptChar(const char c) noexcept{
-            if (std::isupper(c)) {
-                return 90 - (c - 65);;
-            } 
-            else if (std::islower(c)) {
-                return 122 - (c - 97);
-            }
-            return c;
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, Direction, std::size_t) const noexcept override{
+            const std::size_t done = reverseLetters(in, out, simd_level);
+            applyLetterTable(ATBASH_TABLE, in.subspan(done), out.subspan(done));
+            return in.size();
         }
 };
\ No newline at end of file
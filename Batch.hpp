@@ -0,0 +1,113 @@
+/**
+ * @file Batch.hpp
+ * @brief Batch Transform over Packed Records
+ *
+ * Encrypts many short, independent messages in one call. Records are
+ * packed back to back in a single arena and located by an offsets array
+ * (record i is data[offsets[i], offsets[i + 1])), and results come back
+ * in the same layout. Per-record cost drops to at most one kernel call
+ * with no string copies; position-independent, length-preserving ciphers
+ * (Caesar, Atbash) run the kernel once over the whole arena.
+ *
+ * RecordBatch takes an optional std::pmr::memory_resource, so arenas for
+ * a whole request can come from one monotonic buffer.
+ *
+ * Every record is a message of its own: Vigenère starts each one at key
+ * phase 0, and A1Z26 digit pairs never span two records.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include<algorithm>
+#include<cstddef>
+#include<memory_resource>
+#include<span>
+#include<string_view>
+#include<vector>
+
+
+/**
+ * Owning arena of packed records
+ */
+struct RecordBatch {
+    std::pmr::vector<char> data;
+    std::pmr::vector<std::size_t> offsets;
+
+    /**
+     * @param resource Where the arena and offsets are allocated
+     */
+    explicit RecordBatch(std::pmr::memory_resource* const resource = std::pmr::get_default_resource())
+        : data(resource), offsets(1, 0, resource) {}
+
+    void add(const std::string_view record) {
+        data.insert(data.end(), record.begin(), record.end());
+        offsets.push_back(data.size());
+    }
+
+    void clear() noexcept{
+        data.clear();
+        offsets.assign(1, 0);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept{
+        return offsets.size() - 1;
+    }
+
+    [[nodiscard]] std::string_view operator[](const std::size_t i) const noexcept{
+        return {data.data() + offsets[i], offsets[i + 1] - offsets[i]};
+    }
+};
+
+/**
+ * Transforms each record of a packed arena
+ * @param cipher Configured cipher
+ * @param data Record bytes, back to back
+ * @param offsets count + 1 ascending offsets into data, starting at 0
+ * @param out Destination arena, at least
+ *            cipher.maxTransformedSize(data.size()) long
+ * @param out_offsets Receives count + 1 offsets into out
+ * @param d Encrypt or decrypt
+ * @return Bytes written to out
+ * @throws std::length_error if out or out_offsets is too small
+ */
+inline std::size_t transformBatch(const Encryption& cipher, const std::span<const char> data, const std::span<const std::size_t> offsets, const std::span<char> out, const std::span<std::size_t> out_offsets, const Direction d) {
+    if (offsets.empty()) {
+        return 0;
+    }
+    if (out_offsets.size() < offsets.size() or out.size() < cipher.maxTransformedSize(data.size(), d)) {
+        throw std::length_error("transformBatch: output arena too small");
+    }
+    const std::size_t begin = offsets.front();
+    const std::size_t end = offsets.back();
+
+    if (cipher.preservesLength() and cipher.positionIndependent()) {
+        cipher.transform(data.subspan(begin, end - begin), out, d);
+        for (std::size_t i = 0; i < offsets.size(); ++i) {
+            out_offsets[i] = offsets[i] - begin;
+        }
+        return end - begin;
+    }
+
+    std::size_t written = 0;
+    out_offsets[0] = 0;
+    for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+        const auto record = data.subspan(offsets[i], offsets[i + 1] - offsets[i]);
+        written += cipher.transform(record, out.subspan(written), d);
+        out_offsets[i + 1] = written;
+    }
+    return written;
+}
+
+/**
+ * Owning convenience overload; out is resized to fit and reuses its
+ * capacity across calls
+ */
+inline void transformBatch(const Encryption& cipher, const RecordBatch& in, RecordBatch& out, const Direction d) {
+    out.data.resize(cipher.maxTransformedSize(in.data.size(), d));
+    out.offsets.resize(in.offsets.size());
+    out.data.resize(transformBatch(cipher, in.data, in.offsets, out.data, out.offsets, d));
+}
@@ -18,6 +18,8 @@
  * - Case-preserving operations
  * - Non-alphabetic character preservation
  * - Automatic key normalization (handles negative/overflow keys)
+ * - Table-driven engine: encrypt/decrypt tables built once per key
+ * - SIMD kernel for whole vectors, table for the tail (see Simd.hpp)
  * 
  * @author CipherSuite Team
  * @version 1.0
@@ -26,62 +28,66 @@
 
 #pragma once
 #include "Encryptions.hpp"
+#include "SubstitutionTable.hpp"
 
 
 class Caesar final: public Encryption {
     public:
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "caesar";
+        }
+
+        Caesar() noexcept{
+            setKey(0);
+        }
+
         /**
          * Sets the shift key for Caesar cipher
          * Normalizes key to range [0, 25] using modulo arithmetic
          * Handles negative keys and keys > 25 correctly
+         * Rebuilds both translation tables for the new key
          */
         void setKey(int k) noexcept{
             key = ((k % 26) + 26) % 26;
+            encryptTable = makeTable([this](const char c) { return encryptChar(c); });
+            decryptTable = makeTable([this](const char c) { return decryptChar(c); });
         }
 
-        void encrypt() override{
-            encrypted_message.clear();
-            for (const char c : message) {
-                if (std::isalpha(c)) {
-                    encrypted_message += encryptChar(c);
-                }
-                else {
-                    encrypted_message += c;
-                }
-            }
+        /**
+         * Normalized shift key, 0..25
+         */
+        [[nodiscard]] int getKey() const noexcept{
+            return key;
         }
 
-        void decrypt() override{
-            encrypted_message.clear();
-            for (const char c : message) {
-                if (std::isalpha(c)) {
-                    encrypted_message += decryptChar(c);
-                }
-                else {
-                    encrypted_message += c;
-                }
-            }
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, std::size_t) const noexcept override{
+            const int shift = d == Direction::encrypt ? key : (26 - key) % 26;
+            const std::size_t done = shiftLetters(in, out, shift, simd_level);
+            applyLetterTable(d == Direction::encrypt ? encryptTable : decryptTable, in.subspan(done), out.subspan(done));
+            return in.size();
         }
 
     private:
         int key;
+        SubstitutionTable encryptTable;
+        SubstitutionTable decryptTable;
 
         [[nodiscard]] char encryptChar(const char c) const noexcept{
-            if (std::isupper(c)) {
-                return (c - 'A' + key) + 'A';
+            if (isUpperAscii(c)) {
+                return (c - 'A' + key) % 26 + 'A';
             } 
-            else if (std::islower(c)) {
-                return (c - 'a' + key) + 'a';
+            else if (isLowerAscii(c)) {
+                return (c - 'a' + key) % 26 + 'a';
             }
             return c;
         }
 
         [[nodiscard]] char decryptChar(const char c) const noexcept{
-            if (std::isupper(c)) {
-                return (c - 'A' - key) + 'A';
+            if (isUpperAscii(c)) {
+                return (c - 'A' - key + 26) % 26 + 'A';
             } 
-            else if (std::islower(c)) {
-                return (c - 'a' - key) + 'a';
+            else if (isLowerAscii(c)) {
+                return (c - 'a' - key + 26) % 26 + 'a';
             }
             return c;
         }
@@ -0,0 +1,185 @@
+/**
+ * @file CipherCache.hpp
+ * @brief Bounded LRU Cache of Prepared Cipher Contexts
+ *
+ * Building a Caesar table or a Vigenère key schedule costs far more than
+ * transforming a short message with it. Services that see the same
+ * (algorithm, key) pairs again and again can keep the prepared ciphers
+ * here and share them across threads.
+ *
+ * Features:
+ * - Entries are immutable: get() hands out shared_ptr<const Encryption>,
+ *   and the const transform() API needs no synchronization, so the hot
+ *   path takes no lock at all
+ * - Lookups lock one of several shards, not the whole cache
+ * - Least recently used entries are evicted once a shard is full;
+ *   evicted contexts stay alive while callers still hold them
+ * - Misses build the cipher outside the lock
+ * - Hit/miss counters for sizing the cache
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherFactory.hpp"
+#include<algorithm>
+#include<atomic>
+#include<cstddef>
+#include<functional>
+#include<list>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<unordered_map>
+#include<utility>
+#include<vector>
+
+
+/**
+ * Default capacity: enough for a few thousand tenant keys
+ */
+inline constexpr std::size_t CIPHER_CACHE_CAPACITY = 4096;
+
+class CipherCache {
+    public:
+        /**
+         * @param capacity Maximum number of cached contexts (at least one
+         *                 per shard)
+         * @param shards Independently locked partitions
+         */
+        explicit CipherCache(const std::size_t capacity = CIPHER_CACHE_CAPACITY, const std::size_t shards = 16)
+            : shard_capacity(std::max<std::size_t>(1, (capacity + std::max<std::size_t>(shards, 1) - 1) / std::max<std::size_t>(shards, 1))),
+              partitions(std::max<std::size_t>(shards, 1)) {}
+
+        CipherCache(const CipherCache&) = delete;
+        CipherCache& operator=(const CipherCache&) = delete;
+
+        /**
+         * Prepared cipher for (id, key), built on first use
+         * @param key As for makeCipher(); ignored for keyless ciphers
+         * @return Shared immutable context, or nullptr if the key is invalid
+         *         (invalid keys are not cached)
+         */
+        [[nodiscard]] std::shared_ptr<const Encryption> get(const CipherId id, std::string_view key) {
+            if (not needsKey(id)) {
+                key = {};
+            }
+            const std::size_t hash = hashKey(id, key);
+            Shard& shard = partitions[hash % partitions.size()];
+            {
+                const std::lock_guard lock(shard.mutex);
+                if (const auto found = shard.find(id, key, hash); found != shard.entries.end()) {
+                    shard.entries.splice(shard.entries.begin(), shard.entries, found);
+                    hit_count.fetch_add(1, std::memory_order_relaxed);
+                    return found->cipher;
+                }
+            }
+
+            miss_count.fetch_add(1, std::memory_order_relaxed);
+            std::shared_ptr<const Encryption> cipher = makeCipher(id, key);
+            if (not cipher) {
+                return nullptr;
+            }
+
+            const std::lock_guard lock(shard.mutex);
+            // Another thread may have built the same context meanwhile
+            if (const auto found = shard.find(id, key, hash); found != shard.entries.end()) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, found);
+                return found->cipher;
+            }
+            shard.entries.push_front({id, std::string(key), hash, cipher});
+            shard.index.emplace(hash, shard.entries.begin());
+            if (shard.entries.size() > shard_capacity) {
+                shard.erase(std::prev(shard.entries.end()));
+            }
+            return cipher;
+        }
+
+        /**
+         * Drops every cached context
+         */
+        void clear() {
+            for (Shard& shard : partitions) {
+                const std::lock_guard lock(shard.mutex);
+                shard.index.clear();
+                shard.entries.clear();
+            }
+        }
+
+        [[nodiscard]] std::size_t size() const{
+            std::size_t total = 0;
+            for (const Shard& shard : partitions) {
+                const std::lock_guard lock(shard.mutex);
+                total += shard.entries.size();
+            }
+            return total;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept{
+            return shard_capacity * partitions.size();
+        }
+
+        [[nodiscard]] std::size_t hits() const noexcept{
+            return hit_count.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::size_t misses() const noexcept{
+            return miss_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry {
+            CipherId id;
+            std::string key;
+            std::size_t hash;
+            std::shared_ptr<const Encryption> cipher;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::list<Entry> entries;   // most recently used first
+            std::unordered_multimap<std::size_t, std::list<Entry>::iterator> index;
+
+            std::list<Entry>::iterator find(const CipherId id, const std::string_view key, const std::size_t hash) {
+                const auto [first, last] = index.equal_range(hash);
+                for (auto it = first; it != last; ++it) {
+                    if (it->second->id == id and it->second->key == key) {
+                        return it->second;
+                    }
+                }
+                return entries.end();
+            }
+
+            void erase(const std::list<Entry>::iterator entry) {
+                const auto [first, last] = index.equal_range(entry->hash);
+                for (auto it = first; it != last; ++it) {
+                    if (it->second == entry) {
+                        index.erase(it);
+                        break;
+                    }
+                }
+                entries.erase(entry);
+            }
+        };
+
+        std::size_t shard_capacity;
+        std::vector<Shard> partitions;
+        std::atomic<std::size_t> hit_count{0};
+        std::atomic<std::size_t> miss_count{0};
+
+        [[nodiscard]] static std::size_t hashKey(const CipherId id, const std::string_view key) noexcept{
+            const std::size_t h = std::hash<std::string_view>{}(key);
+            return h ^ (static_cast<std::size_t>(id) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+        }
+};
+
+/**
+ * Process-wide cache with the default capacity
+ */
+[[nodiscard]] inline CipherCache& sharedCipherCache() {
+    static CipherCache cache;
+    return cache;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file CipherFactory.hpp
+ * @brief Name-Based Construction of Cipher Objects
+ *
+ * Maps cipher names and textual keys (as they arrive on the command line)
+ * onto configured Encryption objects, so drivers that do not know the
+ * concrete cipher type at compile time can still build one.
+ *
+ * Features:
+ * - Case-sensitive cipher names: caesar, vigenere, a1z26, atbash
+ * - Key validation (integer for Caesar, non-empty keyword for Vigenère)
+ * - Returns nullptr instead of a half-configured cipher on bad input
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "A1Z26.hpp"
+#include "Atbash.hpp"
+#include "Caesar.hpp"
+#include "Vigenere.hpp"
+#include<charconv>
+#include<memory>
+#include<optional>
+#include<string_view>
+
+
+enum class CipherId { caesar, vigenere, a1z26, atbash };
+
+[[nodiscard]] inline std::optional<CipherId> parseCipherId(const std::string_view name) noexcept{
+    if (name == "caesar") {
+        return CipherId::caesar;
+    }
+    if (name == "vigenere") {
+        return CipherId::vigenere;
+    }
+    if (name == "a1z26") {
+        return CipherId::a1z26;
+    }
+    if (name == "atbash") {
+        return CipherId::atbash;
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] constexpr bool needsKey(const CipherId id) noexcept{
+    return id == CipherId::caesar or id == CipherId::vigenere;
+}
+
+/**
+ * Builds a ready-to-use cipher
+ * @param id Cipher to build
+ * @param key Shift for Caesar (may be negative), keyword for Vigenère,
+ *            ignored otherwise
+ * @return Configured cipher, or nullptr if the key is invalid
+ */
+[[nodiscard]] inline std::unique_ptr<Encryption> makeCipher(const CipherId id, const std::string_view key) {
+    switch (id) {
+        case CipherId::caesar: {
+            int shift = 0;
+            const char* const last = key.data() + key.size();
+            const auto [ptr, ec] = std::from_chars(key.data(), last, shift);
+            if (key.empty() or ec != std::errc{} or ptr != last) {
+                return nullptr;
+            }
+            auto caesar = std::make_unique<Caesar>();
+            caesar->setKey(shift);
+            return caesar;
+        }
+        case CipherId::vigenere: {
+            if (key.empty()) {
+                return nullptr;
+            }
+            auto vigenere = std::make_unique<Vigenere>();
+            vigenere->setKeyMessage(std::string(key));
+            return vigenere;
+        }
+        case CipherId::a1z26:
+            return std::make_unique<A1Z26>();
+        case CipherId::atbash:
+            return std::make_unique<Atbash>();
+    }
+    return nullptr;
+}
@@ -0,0 +1,591 @@
+/**
+ * @file CipherPipeline.hpp
+ * @brief Composition of Cipher Stages with Pass Fusion
+ *
+ * Runs a sequence of ciphers as one Encryption: encrypt() applies the
+ * stages first to last, decrypt() undoes them last to first. Since the
+ * pipeline is itself an Encryption, every driver (streaming, parallel,
+ * mmap, async) accepts it unchanged.
+ *
+ * Fusion: on ASCII letter indices x, Caesar, Atbash and Vigenère all have
+ * the form
+ *     x -> s * x + b[i mod p]     (s = +1 or -1, i = stream position)
+ * Caesar is (+1, {k}), Atbash (-1, {25}), Vigenère (+1, key shifts), and
+ * the form is closed under composition. Adjacent stages of this kind are
+ * therefore collapsed into a single pass (AffineLetters) when added:
+ * - Atbash + Caesar: one 256-byte table (p = 1)
+ * - Caesar + Vigenère: one shifted key schedule
+ * - any mix: one schedule of period lcm(key lengths), capped at
+ *   MAX_FUSED_PERIOD
+ * Other stages (A1Z26, user subclasses) run as separate passes.
+ *
+ * Features:
+ * - One read and one write of the data per fused run of stages
+ * - Length-preserving passes run block by block, so a chain of unfused
+ *   passes touches memory once and works in L1 for the rest
+ * - Length-changing passes (A1Z26) stream through fixed stack buffers, so
+ *   no chain allocates while it runs
+ * - "atbash,caesar:3,vigenere:KEY" specs for the command line
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherFactory.hpp"
+#include<algorithm>
+#include<array>
+#include<concepts>
+#include<cstddef>
+#include<memory>
+#include<numeric>
+#include<optional>
+#include<span>
+#include<stdexcept>
+#include<string_view>
+#include<utility>
+#include<vector>
+
+
+/**
+ * Longest key schedule a fused pass may have; stages whose combined
+ * period would exceed it start a new pass instead
+ */
+inline constexpr std::size_t MAX_FUSED_PERIOD = 4096;
+
+/**
+ * Fused letter pass x -> s * x + b[i mod p] (see the file comment)
+ */
+class AffineLetters final: public Encryption {
+    public:
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "fused";
+        }
+
+        /**
+         * @param mirror Whether s is -1 (the alphabet is mirrored first)
+         * @param offsets b, one entry (0..25) per position of the period;
+         *                must not be empty
+         */
+        AffineLetters(const bool mirror, std::vector<unsigned char> offsets)
+            : reflect(mirror), shifts(std::move(offsets)) {
+            buildStreams();
+        }
+
+        /**
+         * Affine form of cipher, or nullopt for ciphers that have none
+         */
+        [[nodiscard]] static std::optional<AffineLetters> of(const Encryption& cipher) {
+            if (const auto* const affine = dynamic_cast<const AffineLetters*>(&cipher)) {
+                return *affine;
+            }
+            if (const auto* const caesar = dynamic_cast<const Caesar*>(&cipher)) {
+                return AffineLetters(false, {static_cast<unsigned char>(caesar->getKey())});
+            }
+            if (dynamic_cast<const Atbash*>(&cipher) != nullptr) {
+                return AffineLetters(true, {25});
+            }
+            if (const auto* const vigenere = dynamic_cast<const Vigenere*>(&cipher)) {
+                const std::span<const unsigned char> key = vigenere->keyShifts();
+                if (key.empty()) {
+                    return AffineLetters(false, {0});
+                }
+                return AffineLetters(false, {key.begin(), key.end()});
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Pass equivalent to this one followed by next
+         * (s2 * (s1 * x + b1) + b2 = s1 s2 * x + (s2 * b1 + b2))
+         */
+        [[nodiscard]] AffineLetters then(const AffineLetters& next) const{
+            const std::size_t combined = std::lcm(period(), next.period());
+            std::vector<unsigned char> composed(combined);
+            for (std::size_t i = 0; i < combined; ++i) {
+                const int first = shifts[i % period()];
+                const int inner = next.reflect ? 26 - first : first;
+                composed[i] = static_cast<unsigned char>((inner + next.shifts[i % next.period()]) % 26);
+            }
+            return AffineLetters(reflect != next.reflect, std::move(composed));
+        }
+
+        [[nodiscard]] std::size_t period() const noexcept{
+            return shifts.size();
+        }
+
+        /**
+         * Whether s is -1
+         */
+        [[nodiscard]] bool mirrored() const noexcept{
+            return reflect;
+        }
+
+        /**
+         * b over one period
+         */
+        [[nodiscard]] std::span<const unsigned char> schedule() const noexcept{
+            return shifts;
+        }
+
+        [[nodiscard]] bool positionIndependent() const noexcept override{
+            return period() == 1;
+        }
+
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset) const noexcept override{
+            const unsigned char* const stream = d == Direction::encrypt or reflect ? encryptStream.data() : decryptStream.data();
+            const SubstitutionTable& table = d == Direction::encrypt or reflect ? encryptTable : decryptTable;
+            std::size_t phase = offset % stream_period;
+            // Mirroring and shifting are two kernels; running both over one
+            // block at a time keeps the second one in L1
+            for (std::size_t start = 0; start < in.size(); start += BLOCK_BYTES) {
+                const std::size_t count = std::min(BLOCK_BYTES, in.size() - start);
+                const auto from = in.subspan(start, count);
+                const auto to = out.subspan(start, count);
+                std::size_t done = 0;
+                if (reflect) {
+                    done = reverseLetters(from, to, simd_level);
+                    shiftLettersStream(to.first(done), to.first(done), stream, stream_period, phase, simd_level);
+                }
+                else {
+                    done = shiftLettersStream(from, to, stream, stream_period, phase, simd_level);
+                }
+                if (period() == 1) {
+                    applyLetterTable(table, from.subspan(done), to.subspan(done));
+                    continue;
+                }
+                for (std::size_t i = done; i < count; ++i) {
+                    to[i] = shiftLetter(reflect ? atbashChar(from[i]) : from[i], stream[phase]);
+                    if (++phase == stream_period) {
+                        phase = 0;
+                    }
+                }
+            }
+            return in.size();
+        }
+
+    private:
+        /**
+         * Same stream layout as Vigenère: a whole number of periods, at
+         * least one cache line, plus room for an unaligned vector load
+         */
+        static constexpr std::size_t MIN_STREAM_PERIOD = 64;
+        static constexpr std::size_t STREAM_PADDING = 32;
+        static constexpr std::size_t BLOCK_BYTES = 4096;
+
+        bool reflect;
+        std::vector<unsigned char> shifts;
+        std::size_t stream_period = 0;
+        // Shifts applied after the optional mirror; a mirrored pass is its
+        // own inverse, so it only uses the encrypt side
+        std::vector<unsigned char> encryptStream;
+        std::vector<unsigned char> decryptStream;
+        SubstitutionTable encryptTable{};
+        SubstitutionTable decryptTable{};
+
+        /**
+         * Mirroring maps x to 25 - x, so a mirrored pass shifts by b + 1
+         * afterwards to land on b - x
+         */
+        void buildStreams() {
+            if (shifts.empty()) {
+                throw std::invalid_argument("AffineLetters: empty shift schedule");
+            }
+            stream_period = period() * ((MIN_STREAM_PERIOD + period() - 1) / period());
+            encryptStream.resize(stream_period + STREAM_PADDING);
+            decryptStream.resize(encryptStream.size());
+            for (std::size_t i = 0; i < encryptStream.size(); ++i) {
+                const int shift = shifts[i % period()];
+                encryptStream[i] = static_cast<unsigned char>(reflect ? (shift + 1) % 26 : shift);
+                decryptStream[i] = static_cast<unsigned char>((26 - shift) % 26);
+            }
+            if (period() == 1) {
+                const int forward = encryptStream[0];
+                const int backward = decryptStream[0];
+                const bool mirror = reflect;
+                encryptTable = makeTable([=](const char c) { return shiftLetter(mirror ? atbashChar(c) : c, forward); });
+                decryptTable = makeTable([=](const char c) { return shiftLetter(c, backward); });
+            }
+        }
+};
+
+class CipherPipeline final: public Encryption {
+    public:
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "pipeline";
+        }
+
+        /**
+         * Appends a stage, fusing it into the previous pass when possible.
+         * A pipeline stage contributes its own stages.
+         * @throws std::invalid_argument if stage is null
+         */
+        CipherPipeline& add(std::shared_ptr<const Encryption> stage) {
+            if (not stage) {
+                throw std::invalid_argument("CipherPipeline: null stage");
+            }
+            if (const auto* const nested = dynamic_cast<const CipherPipeline*>(stage.get())) {
+                const std::vector<std::shared_ptr<const Encryption>> inner = nested->stages;
+                for (const auto& s : inner) {
+                    add(s);
+                }
+                return *this;
+            }
+
+            stages.push_back(stage);
+            std::optional<AffineLetters> form = AffineLetters::of(*stage);
+            if (form and not passes.empty() and passes.back().form
+                and std::lcm(passes.back().form->period(), form->period()) <= MAX_FUSED_PERIOD) {
+                auto fused = std::make_shared<const AffineLetters>(passes.back().form->then(*form));
+                passes.back() = {fused, fused};
+                return *this;
+            }
+            // A stage that fuses with nothing keeps its own kernel
+            std::shared_ptr<const AffineLetters> affine;
+            if (form) {
+                affine = std::make_shared<const AffineLetters>(std::move(*form));
+            }
+            passes.push_back({std::move(stage), std::move(affine)});
+            return *this;
+        }
+
+        /**
+         * Appends a copy of a concrete cipher
+         */
+        template<typename C>
+            requires std::derived_from<C, Encryption>
+        CipherPipeline& add(const C& stage) {
+            return add(std::make_shared<const C>(stage));
+        }
+
+        /**
+         * Stages as added
+         */
+        [[nodiscard]] std::size_t stageCount() const noexcept{
+            return stages.size();
+        }
+
+        /**
+         * Passes over the data after fusion
+         */
+        [[nodiscard]] std::size_t passCount() const noexcept{
+            return passes.size();
+        }
+
+        /**
+         * The single letter pass everything fused into, or nullopt when the
+         * pipeline needs more than one pass or a non-letter kernel
+         */
+        [[nodiscard]] std::optional<AffineLetters> fused() const{
+            if (passes.size() != 1 or not passes.front().form) {
+                return std::nullopt;
+            }
+            return *passes.front().form;
+        }
+
+        [[nodiscard]] bool preservesLength() const noexcept override{
+            return std::all_of(passes.begin(), passes.end(), [](const Pass& p) { return p.cipher->preservesLength(); });
+        }
+
+        [[nodiscard]] bool positionIndependent() const noexcept override{
+            return std::all_of(passes.begin(), passes.end(), [](const Pass& p) { return p.cipher->positionIndependent(); });
+        }
+
+        [[nodiscard]] std::size_t maxTransformedSize(std::size_t n, const Direction d) const noexcept override{
+            for (std::size_t k = 0; k < passes.size(); ++k) {
+                n = pass(k, d).maxTransformedSize(n, d);
+            }
+            return n;
+        }
+
+        /**
+         * A1Z26 encryption sizes by character class alone, and letter
+         * passes keep letters letters and digits digits, so when it is the
+         * only length-changing pass and only letter passes come before it,
+         * its answer on the raw input holds. Otherwise the passes stream up
+         * to the last length-changing one, which is only measured (a
+         * Vigenère stage decides which letters reach A1Z26 decryption,
+         * hence the offset).
+         */
+        [[nodiscard]] std::size_t transformedSize(const std::span<const char> in, const Direction d, const std::size_t offset = 0) const noexcept override{
+            if (passes.empty() or preservesLength()) {
+                return in.size();
+            }
+            std::size_t first = 0;
+            while (pass(first, d).preservesLength() and passForm(first, d) != nullptr) {
+                ++first;
+            }
+            std::size_t later = first + 1;
+            while (later < passes.size() and pass(later, d).preservesLength()) {
+                ++later;
+            }
+            if (d == Direction::encrypt and later == passes.size() and dynamic_cast<const A1Z26*>(&pass(first, d)) != nullptr) {
+                return pass(first, d).transformedSize(in, d, offset);
+            }
+            Output output{{}, 0, true};
+            stream(nullptr, nullptr, 0, in, d, offset, output);
+            return output.written;
+        }
+
+        /**
+         * Bytes only stay aligned with the input up to the first
+         * length-changing pass; the stages before it keep letters letters
+         * and digits digits, so its own answer on the raw input holds.
+         * Pipelines that cannot be cut (see cuttable()) hold everything back.
+         */
+        [[nodiscard]] std::size_t completeLength(const std::string_view input, const Direction d) const noexcept override{
+            if (not cuttable(d)) {
+                return 0;
+            }
+            std::size_t length = input.size();
+            for (std::size_t k = 0; k < passes.size(); ++k) {
+                length = std::min(length, pass(k, d).completeLength(input.substr(0, length), d));
+                if (not pass(k, d).preservesLength()) {
+                    break;
+                }
+            }
+            return length;
+        }
+
+        [[nodiscard]] std::size_t splitPoint(const std::span<const char> in, const std::size_t hint, const Direction d) const noexcept override{
+            if (not cuttable(d)) {
+                return in.size();
+            }
+            for (std::size_t k = 0; k < passes.size(); ++k) {
+                if (not pass(k, d).preservesLength()) {
+                    return pass(k, d).splitPoint(in, hint, d);
+                }
+            }
+            return std::min(hint, in.size());
+        }
+
+        /**
+         * offset reaches the passes up to the first length-changing one;
+         * the passes after it see their input from position 0
+         */
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset) const noexcept override{
+            if (passes.empty()) {
+                if (in.data() != out.data()) {
+                    std::copy(in.begin(), in.end(), out.begin());
+                }
+                return in.size();
+            }
+            if (passes.size() == 1) {
+                return passes.front().cipher->transform(in, out, d, offset);
+            }
+            if (not preservesLength()) {
+                Output output{out, 0, false};
+                stream(nullptr, nullptr, 0, in, d, offset, output);
+                return output.written;
+            }
+            for (std::size_t start = 0; start < in.size(); start += BLOCK_BYTES) {
+                const std::size_t count = std::min(BLOCK_BYTES, in.size() - start);
+                const auto to = out.subspan(start, count);
+                pass(0, d).transform(in.subspan(start, count), to, d, offset + start);
+                for (std::size_t k = 1; k < passes.size(); ++k) {
+                    pass(k, d).transformInPlace(to, d, offset + start);
+                }
+            }
+            return in.size();
+        }
+
+    private:
+        /**
+         * Unfused chains of length-preserving passes run over one L1-sized
+         * block at a time
+         */
+        static constexpr std::size_t BLOCK_BYTES = 16384;
+
+        /**
+         * Input a length-changing pass takes per step; its output goes to a
+         * buffer twice that size on the stack
+         */
+        static constexpr std::size_t SEGMENT_BYTES = 4096;
+
+        struct Pass {
+            std::shared_ptr<const Encryption> cipher;
+            std::shared_ptr<const AffineLetters> form;   // null unless fusable
+        };
+
+        /**
+         * Length-preserving passes [first, end) followed by the
+         * length-changing pass end, or the passes after the last
+         * length-changing one when end is passes.size(). Bytes the
+         * length-changing pass cannot finish yet (completeLength()) wait in
+         * held for the next step.
+         */
+        struct Segment {
+            std::size_t first = 0;
+            std::size_t end = 0;
+            std::size_t position = 0;    // stream position of held[0]
+            std::size_t held_bytes = 0;
+            std::array<char, SEGMENT_BYTES> held;
+            Segment* next = nullptr;
+        };
+
+        /**
+         * Where the last segment's bytes go; counting only adds up sizes
+         */
+        struct Output {
+            std::span<char> out;
+            std::size_t written;
+            bool counting;
+        };
+
+        std::vector<std::shared_ptr<const Encryption>> stages;
+        std::vector<Pass> passes;
+
+        /**
+         * k-th pass in the order direction d runs them
+         */
+        [[nodiscard]] const Encryption& pass(const std::size_t k, const Direction d) const noexcept{
+            return *passes[d == Direction::encrypt ? k : passes.size() - 1 - k].cipher;
+        }
+
+        /**
+         * Whether chunks can be transformed independently: at most one
+         * length-changing pass, and nothing after it that depends on the
+         * stream position (its positions no longer match the input's)
+         */
+        [[nodiscard]] bool cuttable(const Direction d) const noexcept{
+            std::size_t k = 0;
+            while (k < passes.size() and pass(k, d).preservesLength()) {
+                ++k;
+            }
+            for (++k; k < passes.size(); ++k) {
+                if (not pass(k, d).preservesLength() or not pass(k, d).positionIndependent()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] const AffineLetters* passForm(const std::size_t k, const Direction d) const noexcept{
+            return passes[d == Direction::encrypt ? k : passes.size() - 1 - k].form.get();
+        }
+
+        /**
+         * Lays out one Segment per length-changing pass (plus the last) in
+         * this frame and the ones it calls, then feeds in through them
+         * @param first First pass of the segment to create
+         * @param offset Stream position of in[0]; reaches the first segment
+         *               only, the later ones start from 0
+         */
+        void stream(Segment* const head, Segment* const previous, const std::size_t first, const std::span<const char> in, const Direction d,
+            const std::size_t offset, Output& output) const noexcept{
+            Segment segment;
+            segment.first = first;
+            segment.end = first;
+            while (segment.end < passes.size() and pass(segment.end, d).preservesLength()) {
+                ++segment.end;
+            }
+            if (previous != nullptr) {
+                previous->next = &segment;
+            }
+            Segment* const root = head != nullptr ? head : &segment;
+            if (segment.end < passes.size()) {
+                stream(root, &segment, segment.end + 1, in, d, offset, output);
+                return;
+            }
+            root->position = offset;
+            feed(*root, in, true, d, output);
+        }
+
+        /**
+         * Pushes the next bytes of segment s's input through it and the
+         * segments after it
+         * @param last Whether data ends the stream (everything held is
+         *             released)
+         */
+        void feed(Segment& s, std::span<const char> data, const bool last, const Direction d, Output& output) const noexcept{
+            if (s.end == passes.size()) {
+                if (not output.counting and not data.empty()) {
+                    const std::span<char> to = output.out.subspan(output.written, data.size());
+                    if (s.first == s.end) {
+                        std::copy(data.begin(), data.end(), to.begin());
+                    }
+                    else {
+                        pass(s.first, d).transform(data, to, d, s.position);
+                        for (std::size_t k = s.first + 1; k < s.end; ++k) {
+                            pass(k, d).transformInPlace(to, d, s.position);
+                        }
+                    }
+                }
+                output.written += data.size();
+                s.position += data.size();
+                return;
+            }
+            if (data.empty() and not last) {
+                return;
+            }
+
+            const Encryption& changer = pass(s.end, d);
+            std::size_t capacity = SEGMENT_BYTES;
+            while (capacity > 1 and changer.maxTransformedSize(capacity, d) > 2 * SEGMENT_BYTES) {
+                capacity /= 2;
+            }
+            do {
+                const std::size_t take = std::min(data.size(), capacity - s.held_bytes);
+                const std::span<char> fresh(s.held.data() + s.held_bytes, take);
+                const std::size_t position = s.position + s.held_bytes;
+                if (s.first == s.end) {
+                    std::copy_n(data.data(), take, fresh.data());
+                }
+                else {
+                    pass(s.first, d).transform(data.first(take), fresh, d, position);
+                    for (std::size_t k = s.first + 1; k < s.end; ++k) {
+                        pass(k, d).transformInPlace(fresh, d, position);
+                    }
+                }
+                data = data.subspan(take);
+
+                const std::size_t n = s.held_bytes + take;
+                const bool final = last and data.empty();
+                std::size_t complete = final ? n : changer.completeLength({s.held.data(), n}, d);
+                if (complete == 0 and n == capacity) {
+                    complete = n;    // a pass may not hold back a whole step
+                }
+                const std::span<const char> ready(s.held.data(), complete);
+                if (output.counting and s.next->end == passes.size()) {
+                    output.written += changer.transformedSize(ready, d, s.position);
+                }
+                else {
+                    std::array<char, 2 * SEGMENT_BYTES> produced;
+                    const std::size_t written = changer.transform(ready, produced, d, s.position);
+                    feed(*s.next, {produced.data(), written}, final, d, output);
+                }
+                std::copy(s.held.begin() + complete, s.held.begin() + n, s.held.begin());
+                s.held_bytes = n - complete;
+                s.position += complete;
+            } while (not data.empty());
+        }
+};
+
+/**
+ * Builds a pipeline from a comma-separated list of stages, each a cipher
+ * name optionally followed by ":KEY" (as for makeCipher()), e.g.
+ * "atbash,caesar:3,vigenere:SECRET". Keys cannot contain commas.
+ * @return Configured pipeline, or nullptr if any stage is invalid
+ */
+[[nodiscard]] inline std::unique_ptr<CipherPipeline> parsePipeline(std::string_view spec) {
+    auto pipeline = std::make_unique<CipherPipeline>();
+    while (true) {
+        const std::size_t comma = spec.find(',');
+        const std::string_view item = spec.substr(0, comma);
+        const std::size_t colon = item.find(':');
+        const auto id = parseCipherId(item.substr(0, colon));
+        if (not id) {
+            return nullptr;
+        }
+        std::shared_ptr<const Encryption> stage = makeCipher(*id, colon == std::string_view::npos ? std::string_view{} : item.substr(colon + 1));
+        if (not stage) {
+            return nullptr;
+        }
+        pipeline->add(std::move(stage));
+        if (comma == std::string_view::npos) {
+            return pipeline;
+        }
+        spec.remove_prefix(comma + 1);
+    }
+}
@@ -0,0 +1,876 @@
+/**
+ * @file Cli.hpp
+ * @brief Non-Interactive Command-Line Mode
+ *
+ * Flag-driven front end for scripted use. Selected by main() whenever
+ * arguments are present; the interactive menu remains the default.
+ *
+ * Usage:
+ *   cipher_suite --cipher caesar --key 3 --encrypt -i in.txt -o out.txt
+ *   cat log | cipher_suite --cipher vigenere --key SECRET --decrypt
+ *   cipher_suite --cipher atbash --encrypt -i archive.tar --in-place
+ *   cipher_suite --cipher vigenere --crack -i lost_key.txt
+ *   cipher_suite --chain atbash,caesar:3,vigenere:SECRET --encrypt -i in.txt
+ *   cipher_suite --cipher vigenere --key SECRET --decrypt -i huge.enc --range 1048576:4096
+ *   cipher_suite --serve unix:/run/cipher.sock --threads 8
+ *   cipher_suite --cipher caesar --key 3 --encrypt --batch archive/ -o archive.enc/
+ *   cipher_suite --cipher vigenere --key SECRET --encrypt --container -i logs.txt -o logs.csc
+ *
+ * Features:
+ * - Streams stdin/files in bounded chunks (see Stream.hpp)
+ * - Optional multithreading within each chunk (see Parallel.hpp)
+ * - Zero-copy memory-mapped mode for files (see MappedFile.hpp)
+ * - Overlapped read/transform/write on io_uring (see AsyncPipeline.hpp)
+ * - Key recovery by frequency analysis (see Analysis.hpp)
+ * - Fused multi-cipher chains (see CipherPipeline.hpp)
+ * - Random-access decryption of a byte range (see RandomAccess.hpp)
+ * - Socket server and matching one-shot client (see Server.hpp)
+ * - Whole directory trees on a work-stealing scheduler (see FileBatch.hpp)
+ * - OpenCL offload of the letter ciphers with CPU fallback (see Offload.hpp)
+ * - Compressed block containers with random access (see Container.hpp)
+ * - --stats counters on stderr in builds with CIPHERSUITE_STATS (see Stats.hpp)
+ * - "-" or an omitted path means stdin/stdout
+ * - Non-zero exit status and a message on stderr for any error
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Analysis.hpp"
+#include "AsyncPipeline.hpp"
+#include "CipherFactory.hpp"
+#include "CipherPipeline.hpp"
+#include "Container.hpp"
+#include "FileBatch.hpp"
+#include "MappedFile.hpp"
+#include "Offload.hpp"
+#include "RandomAccess.hpp"
+#include "Server.hpp"
+#include "Stats.hpp"
+#include "Stream.hpp"
+#include<atomic>
+#include<charconv>
+#include<csignal>
+#include<cstdio>
+#include<fstream>
+#include<iostream>
+#include<iterator>
+#include<limits>
+#include<optional>
+#include<print>
+#include<string>
+#include<string_view>
+
+
+struct CliOptions {
+    std::optional<CipherId> cipher;
+    std::string chain;
+    std::string key;
+    std::optional<Direction> direction;
+    std::string input = "-";
+    std::string output = "-";
+    std::size_t chunk_size = DEFAULT_CHUNK_SIZE;
+    bool chunk_size_set = false;
+    unsigned threads = 1;
+    bool threads_set = false;
+    bool mapped = false;
+    bool in_place = false;
+    bool async = false;
+    IoBackend io_backend = IoBackend::automatic;
+    unsigned queue_depth = PIPELINE_DEPTH;
+    bool crack = false;
+    std::optional<std::size_t> range_offset;
+    std::size_t range_length = std::numeric_limits<std::size_t>::max();
+    std::string serve;
+    std::string connect;
+    std::string batch;
+    bool offload = false;
+    bool container = false;
+    bool stats = false;
+    stats::Format stats_format = stats::Format::json;
+};
+
+/**
+ * Parses a non-negative decimal count, rejecting trailing characters
+ */
+template<typename T>
+[[nodiscard]] std::optional<T> parseCount(const std::string_view text) noexcept{
+    T value{};
+    const char* const last = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+    if (text.empty() or ec != std::errc{} or ptr != last) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+inline void printUsage() {
+    std::println(stderr, "Usage: cipher_suite (--cipher NAME [--key KEY] | --chain SPEC) (--encrypt | --decrypt | --crack)");
+    std::println(stderr, "                    [-i INPUT] [-o OUTPUT] [--chunk-size BYTES] [--threads N]");
+    std::println(stderr, "                    [--mmap | --in-place] [--async [--io-backend NAME] [--queue-depth N]]");
+    std::println(stderr, "                    [--range OFFSET[:LENGTH]] [--connect ADDRESS] [--batch DIR] [--container] [--offload] [--stats [--stats-format FORMAT]]");
+    std::println(stderr, "       cipher_suite --serve ADDRESS [--threads N]");
+    std::println(stderr, "");
+    std::println(stderr, "  --cipher NAME        caesar, vigenere, a1z26 or atbash");
+    std::println(stderr, "  --key KEY            shift for caesar, keyword for vigenere");
+    std::println(stderr, "  --chain SPEC         apply several ciphers in order, e.g. atbash,caesar:3,vigenere:KEY");
+    std::println(stderr, "                       (decrypting undoes them in reverse)");
+    std::println(stderr, "  -e, --encrypt        encrypt the input");
+    std::println(stderr, "  -d, --decrypt        decrypt the input");
+    std::println(stderr, "  --crack              print the key recovered from English ciphertext");
+    std::println(stderr, "                       (caesar and vigenere only)");
+    std::println(stderr, "  -i, --input PATH     read from PATH instead of stdin");
+    std::println(stderr, "  -o, --output PATH    write to PATH instead of stdout");
+    std::println(stderr, "  --chunk-size BYTES   streaming chunk size (default {})", DEFAULT_CHUNK_SIZE);
+    std::println(stderr, "  -j, --threads N      transform each chunk on N threads, 0 = all cores (default 1)");
+    std::println(stderr, "  --mmap               map INPUT and OUTPUT files instead of streaming");
+    std::println(stderr, "  --in-place           rewrite INPUT through a writable mapping");
+    std::println(stderr, "                       (--mmap and --in-place: caesar, vigenere and atbash only)");
+    std::println(stderr, "  --async              overlap reading, transforming and writing");
+    std::println(stderr, "  --io-backend NAME    auto, uring or threads (implies --async, default auto)");
+    std::println(stderr, "  --queue-depth N      chunks in flight (implies --async, default {})", PIPELINE_DEPTH);
+    std::println(stderr, "  --range OFF[:LEN]    transform only LEN bytes of INPUT starting at byte OFF,");
+    std::println(stderr, "                       without reading what comes before (caesar, vigenere, atbash)");
+    std::println(stderr, "  --serve ADDRESS      serve requests on unix:PATH or [tcp:]HOST:PORT with N workers");
+    std::println(stderr, "                       (default: all cores) until SIGINT or SIGTERM");
+    std::println(stderr, "  --connect ADDRESS    send the input to a server as one request (--cipher only)");
+    std::println(stderr, "  --batch DIR          transform every file below DIR into the directory given by -o,");
+    std::println(stderr, "                       on N threads (default: all cores), then print a summary");
+    std::println(stderr, "  --container          encrypt into a compressed block container, decrypt one back;");
+    std::println(stderr, "                       with --range, OFF and LEN count plaintext bytes");
+    std::println(stderr, "                       (--chunk-size sets the block size, default {})", CONTAINER_BLOCK_SIZE);
+    std::println(stderr, "  --offload            run caesar, vigenere, atbash and chains of them on an OpenCL GPU");
+    std::println(stderr, "                       when one is present and chunks are large enough, else on the CPU");
+    std::println(stderr, "  --stats              print per-cipher and I/O counters to stderr when done");
+    std::println(stderr, "                       (needs a build with STATS=1)");
+    std::println(stderr, "  --stats-format FMT   json or prometheus (implies --stats, default json)");
+    std::println(stderr, "");
+    std::println(stderr, "Run without arguments for the interactive menu.");
+}
+
+/**
+ * Parses command-line flags
+ * @return Options, or nullopt after reporting the problem on stderr
+ */
+[[nodiscard]] inline std::optional<CliOptions> parseArgs(const int argc, char* argv[]) {
+    CliOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto value = [&]() -> std::optional<std::string_view> {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Missing value for {}", arg);
+                return std::nullopt;
+            }
+            return std::string_view(argv[++i]);
+        };
+
+        if (arg == "--cipher") {
+            const auto name = value();
+            if (not name) {
+                return std::nullopt;
+            }
+            options.cipher = parseCipherId(*name);
+            if (not options.cipher) {
+                std::println(stderr, "Unknown cipher '{}'", *name);
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--chain") {
+            const auto spec = value();
+            if (not spec) {
+                return std::nullopt;
+            }
+            options.chain = *spec;
+        }
+        else if (arg == "--key") {
+            const auto key = value();
+            if (not key) {
+                return std::nullopt;
+            }
+            options.key = *key;
+        }
+        else if (arg == "-e" or arg == "--encrypt") {
+            options.direction = Direction::encrypt;
+        }
+        else if (arg == "-d" or arg == "--decrypt") {
+            options.direction = Direction::decrypt;
+        }
+        else if (arg == "--crack") {
+            options.crack = true;
+        }
+        else if (arg == "-i" or arg == "--input") {
+            const auto path = value();
+            if (not path) {
+                return std::nullopt;
+            }
+            options.input = *path;
+        }
+        else if (arg == "-o" or arg == "--output") {
+            const auto path = value();
+            if (not path) {
+                return std::nullopt;
+            }
+            options.output = *path;
+        }
+        else if (arg == "--chunk-size") {
+            const auto bytes = value();
+            if (not bytes) {
+                return std::nullopt;
+            }
+            const auto size = parseCount<std::size_t>(*bytes);
+            if (not size or *size == 0) {
+                std::println(stderr, "Invalid chunk size '{}'", *bytes);
+                return std::nullopt;
+            }
+            options.chunk_size = *size;
+            options.chunk_size_set = true;
+        }
+        else if (arg == "-j" or arg == "--threads") {
+            const auto count = value();
+            if (not count) {
+                return std::nullopt;
+            }
+            const auto threads = parseCount<unsigned>(*count);
+            if (not threads) {
+                std::println(stderr, "Invalid thread count '{}'", *count);
+                return std::nullopt;
+            }
+            options.threads = *threads == 0 ? hardwareThreads() : *threads;
+            options.threads_set = true;
+        }
+        else if (arg == "--mmap") {
+            options.mapped = true;
+        }
+        else if (arg == "--in-place") {
+            options.in_place = true;
+        }
+        else if (arg == "--async") {
+            options.async = true;
+        }
+        else if (arg == "--io-backend") {
+            const auto name = value();
+            if (not name) {
+                return std::nullopt;
+            }
+            const auto backend = parseIoBackend(*name);
+            if (not backend) {
+                std::println(stderr, "Unknown I/O backend '{}'", *name);
+                return std::nullopt;
+            }
+            options.io_backend = *backend;
+            options.async = true;
+        }
+        else if (arg == "--queue-depth") {
+            const auto count = value();
+            if (not count) {
+                return std::nullopt;
+            }
+            const auto depth = parseCount<unsigned>(*count);
+            if (not depth or *depth == 0) {
+                std::println(stderr, "Invalid queue depth '{}'", *count);
+                return std::nullopt;
+            }
+            options.queue_depth = *depth;
+            options.async = true;
+        }
+        else if (arg == "--range") {
+            const auto text = value();
+            if (not text) {
+                return std::nullopt;
+            }
+            const std::size_t colon = text->find(':');
+            const auto offset = parseCount<std::size_t>(text->substr(0, colon));
+            const auto length = colon == std::string_view::npos ? std::optional(options.range_length) : parseCount<std::size_t>(text->substr(colon + 1));
+            if (not offset or not length) {
+                std::println(stderr, "Invalid range '{}'", *text);
+                return std::nullopt;
+            }
+            options.range_offset = offset;
+            options.range_length = *length;
+        }
+        else if (arg == "--batch") {
+            const auto dir = value();
+            if (not dir) {
+                return std::nullopt;
+            }
+            options.batch = *dir;
+        }
+        else if (arg == "--serve" or arg == "--connect") {
+            const auto address = value();
+            if (not address) {
+                return std::nullopt;
+            }
+            (arg == "--serve" ? options.serve : options.connect) = *address;
+        }
+        else if (arg == "--container") {
+            options.container = true;
+        }
+        else if (arg == "--offload") {
+            options.offload = true;
+        }
+        else if (arg == "--stats") {
+            options.stats = true;
+        }
+        else if (arg == "--stats-format") {
+            const auto name = value();
+            if (not name) {
+                return std::nullopt;
+            }
+            const auto format = stats::parseFormat(*name);
+            if (not format) {
+                std::println(stderr, "Unknown stats format '{}'", *name);
+                return std::nullopt;
+            }
+            options.stats_format = *format;
+            options.stats = true;
+        }
+        else if (arg == "-h" or arg == "--help") {
+            printUsage();
+            return std::nullopt;
+        }
+        else {
+            std::println(stderr, "Unknown option '{}'", arg);
+            return std::nullopt;
+        }
+    }
+
+    if (options.stats and not stats::ENABLED) {
+        std::println(stderr, "--stats needs a build with CIPHERSUITE_STATS=1 (make STATS=1)");
+        return std::nullopt;
+    }
+    if (not options.serve.empty()) {
+        if (options.cipher or not options.chain.empty() or options.direction or options.crack or options.mapped
+            or options.in_place or options.async or options.range_offset or not options.connect.empty() or not options.batch.empty() or options.offload or options.container) {
+            std::println(stderr, "--serve cannot be combined with other modes");
+            return std::nullopt;
+        }
+        return options;
+    }
+    if (options.cipher.has_value() == not options.chain.empty()) {
+        std::println(stderr, "Exactly one of --cipher or --chain is required");
+        return std::nullopt;
+    }
+    if (options.crack) {
+        if (not options.cipher) {
+            std::println(stderr, "--crack needs --cipher");
+            return std::nullopt;
+        }
+        if (options.direction or options.mapped or options.in_place or options.async or options.range_offset or not options.batch.empty() or options.offload or options.container) {
+            std::println(stderr, "--crack cannot be combined with other modes");
+            return std::nullopt;
+        }
+        if (options.cipher != CipherId::caesar and options.cipher != CipherId::vigenere) {
+            std::println(stderr, "--crack supports caesar and vigenere only");
+            return std::nullopt;
+        }
+        return options;
+    }
+    if (not options.direction) {
+        std::println(stderr, "One of --encrypt or --decrypt is required");
+        return std::nullopt;
+    }
+    if ((options.mapped or options.in_place) and options.input == "-") {
+        std::println(stderr, "--mmap and --in-place need an input file");
+        return std::nullopt;
+    }
+    if (options.mapped and not options.in_place and options.output == "-") {
+        std::println(stderr, "--mmap needs an output file; use --in-place to rewrite the input");
+        return std::nullopt;
+    }
+    if (options.in_place and options.output != "-") {
+        std::println(stderr, "--in-place cannot be combined with --output");
+        return std::nullopt;
+    }
+    if (options.async and (options.mapped or options.in_place)) {
+        std::println(stderr, "--async cannot be combined with --mmap or --in-place");
+        return std::nullopt;
+    }
+    if (options.range_offset and (options.mapped or options.in_place or options.async)) {
+        std::println(stderr, "--range cannot be combined with --mmap, --in-place or --async");
+        return std::nullopt;
+    }
+    if (not options.connect.empty() and (not options.cipher or options.mapped or options.in_place or options.async or options.range_offset)) {
+        std::println(stderr, "--connect needs --cipher and cannot be combined with other modes");
+        return std::nullopt;
+    }
+    if (not options.batch.empty()) {
+        if (options.input != "-" or options.output == "-") {
+            std::println(stderr, "--batch takes the input directory itself and needs an output directory (-o)");
+            return std::nullopt;
+        }
+        if (options.mapped or options.in_place or options.async or options.range_offset or not options.connect.empty()) {
+            std::println(stderr, "--batch cannot be combined with other modes");
+            return std::nullopt;
+        }
+    }
+    if (options.container) {
+        if (options.mapped or options.in_place or options.async or not options.connect.empty() or not options.batch.empty()) {
+            std::println(stderr, "--container cannot be combined with --mmap, --in-place, --async, --connect or --batch");
+            return std::nullopt;
+        }
+        if (*options.direction == Direction::encrypt ? options.output == "-" or options.range_offset : options.input == "-") {
+            std::println(stderr, "--container writes and reads container files: encrypting needs -o (and no --range), decrypting -i");
+            return std::nullopt;
+        }
+    }
+    if (options.range_offset and options.input == "-") {
+        std::println(stderr, "--range needs an input file");
+        return std::nullopt;
+    }
+    return options;
+}
+
+/**
+ * --mmap / --in-place: transforms files through memory mappings
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runMapped(const Encryption& cipher, const CliOptions& options, ThreadPool* const pool) {
+    if (not cipher.preservesLength()) {
+        std::println(stderr, "--mmap and --in-place need a length-preserving cipher (caesar, vigenere or atbash)");
+        return 1;
+    }
+#if CIPHERSUITE_HAS_MMAP
+    try {
+        if (options.in_place) {
+            mappedTransformInPlace(cipher, options.input, *options.direction, pool);
+        }
+        else {
+            mappedTransform(cipher, options.input, options.output, *options.direction, pool);
+        }
+    }
+    catch (const std::system_error& e) {
+        std::println(stderr, "Mapping failed: {}", e.what());
+        return 1;
+    }
+    return 0;
+#else
+    (void)pool;
+    std::println(stderr, "--mmap and --in-place are not supported on this platform");
+    return 1;
+#endif
+}
+
+/**
+ * --async: runs the overlapped I/O pipeline on raw descriptors
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runAsync(const Encryption& cipher, const CliOptions& options, std::size_t chunk_size, ThreadPool* const pool) {
+#if CIPHERSUITE_HAS_POSIX_IO
+    const std::unique_ptr<IoEngine> engine = makeIoEngine(options.io_backend, options.queue_depth);
+    if (not engine) {
+        std::println(stderr, "io_uring is not available on this system");
+        return 1;
+    }
+    if (not options.chunk_size_set) {
+        chunk_size = std::max(chunk_size, PIPELINE_CHUNK_SIZE);
+    }
+
+    const int in_fd = options.input == "-" ? STDIN_FILENO : ::open(options.input.c_str(), O_RDONLY);
+    if (in_fd < 0) {
+        std::println(stderr, "Cannot open input '{}'", options.input);
+        return 1;
+    }
+    const int out_fd = options.output == "-" ? STDOUT_FILENO : ::open(options.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        std::println(stderr, "Cannot open output '{}'", options.output);
+        if (in_fd != STDIN_FILENO) {
+            ::close(in_fd);
+        }
+        return 1;
+    }
+
+    const bool ok = pipelineTransform(*engine, cipher, *options.direction, in_fd, out_fd, chunk_size, options.queue_depth, pool);
+    if (in_fd != STDIN_FILENO) {
+        ::close(in_fd);
+    }
+    if (out_fd != STDOUT_FILENO and ::close(out_fd) != 0) {
+        std::println(stderr, "I/O error while closing output");
+        return 1;
+    }
+    if (not ok) {
+        std::println(stderr, "I/O error in async pipeline");
+        return 1;
+    }
+    return 0;
+#else
+    (void)cipher, (void)options, (void)chunk_size, (void)pool;
+    std::println(stderr, "--async is not supported on this platform");
+    return 1;
+#endif
+}
+
+/**
+ * --range: transforms one byte range of the input file
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runRange(const Encryption& cipher, const CliOptions& options) {
+    if (not cipher.preservesLength()) {
+        std::println(stderr, "--range needs a length-preserving cipher (caesar, vigenere or atbash)");
+        return 1;
+    }
+    std::string range;
+    try {
+        range = transformFileRange(cipher, options.input, *options.range_offset, options.range_length, *options.direction);
+    }
+    catch (const std::system_error& e) {
+        std::println(stderr, "Range read failed: {}", e.what());
+        return 1;
+    }
+
+    std::ofstream file_out;
+    if (options.output != "-") {
+        file_out.open(options.output, std::ios::binary | std::ios::trunc);
+        if (not file_out) {
+            std::println(stderr, "Cannot open output '{}'", options.output);
+            return 1;
+        }
+    }
+    std::ostream& out = file_out.is_open() ? static_cast<std::ostream&>(file_out) : std::cout;
+    out.write(range.data(), static_cast<std::streamsize>(range.size()));
+    out.flush();
+    if (not out) {
+        std::println(stderr, "I/O error while writing");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * --container: packs the input into a container file, or unpacks one
+ * (all of it, or the plaintext range given by --range)
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runContainer(const Encryption& cipher, const CliOptions& options, ThreadPool* const pool) {
+    if (not cipher.preservesLength()) {
+        std::println(stderr, "--container needs a length-preserving cipher (caesar, vigenere, atbash or chains of them)");
+        return 1;
+    }
+    ThreadPool serial(0);
+    ThreadPool& threads = pool ? *pool : serial;
+    try {
+        if (*options.direction == Direction::encrypt) {
+            std::string buffer;
+#if CIPHERSUITE_HAS_MMAP
+            std::optional<MappedFile> mapped;
+#endif
+            std::span<const char> plain;
+            if (options.input != "-") {
+#if CIPHERSUITE_HAS_MMAP
+                mapped.emplace(options.input, MappedFile::Mode::read);
+                plain = mapped->data();
+#else
+                std::ifstream file(options.input, std::ios::binary);
+                if (not file) {
+                    std::println(stderr, "Cannot open input '{}'", options.input);
+                    return 1;
+                }
+                buffer.assign(std::istreambuf_iterator<char>(file), {});
+                plain = buffer;
+#endif
+            }
+            else {
+                buffer.assign(std::istreambuf_iterator<char>(std::cin), {});
+                plain = buffer;
+            }
+            const ContainerInfo info = writeContainer(cipher, plain, options.output, threads,
+                {.block_size = options.chunk_size_set ? options.chunk_size : CONTAINER_BLOCK_SIZE});
+            std::println(stderr, "{} bytes in {} blocks stored as {} bytes", info.plain_size, info.blocks.size(), info.fileSize());
+            return 0;
+        }
+
+        std::ofstream file_out;
+        if (options.output != "-") {
+            file_out.open(options.output, std::ios::binary | std::ios::trunc);
+            if (not file_out) {
+                std::println(stderr, "Cannot open output '{}'", options.output);
+                return 1;
+            }
+        }
+        std::ostream& out = file_out.is_open() ? static_cast<std::ostream&>(file_out) : std::cout;
+        if (options.range_offset) {
+            const std::string range = readContainerRange(cipher, options.input, *options.range_offset, options.range_length);
+            out.write(range.data(), static_cast<std::streamsize>(range.size()));
+            out.flush();
+            if (not out) {
+                std::println(stderr, "I/O error while writing");
+                return 1;
+            }
+        }
+        else {
+            unpackContainer(cipher, options.input, out, threads);
+        }
+    }
+    catch (const std::exception& e) {
+        std::println(stderr, "Container failed: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * --batch: transforms a directory tree and reports the totals on stderr
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runBatch(const Encryption& cipher, const CliOptions& options) {
+    BatchSummary summary;
+    try {
+        summary = transformDirectory(cipher, options.batch, options.output, *options.direction,
+            options.threads_set ? options.threads : hardwareThreads(), options.chunk_size_set ? options.chunk_size : PARALLEL_CHUNK_SIZE);
+    }
+    catch (const std::exception& e) {
+        std::println(stderr, "Batch failed: {}", e.what());
+        return 1;
+    }
+    for (const std::string& error : summary.errors) {
+        std::println(stderr, "Failed: {}", error);
+    }
+
+    char rate[32];
+    const auto [end, ec] = std::to_chars(rate, rate + sizeof(rate), summary.throughput() / 1e6, std::chars_format::fixed, 1);
+    char seconds[32];
+    const auto [seconds_end, seconds_ec] = std::to_chars(seconds, seconds + sizeof(seconds), summary.seconds, std::chars_format::fixed, 3);
+    std::println(stderr, "{} files ({} failed), {} bytes in, {} bytes out in {} s: {} MB/s on {} threads ({} tasks, {} stolen)",
+        summary.files, summary.errors.size(), summary.bytes_in, summary.bytes_out, std::string_view(seconds, seconds_end),
+        std::string_view(rate, end), summary.threads, summary.tasks, summary.steals);
+    return summary.errors.empty() ? 0 : 1;
+}
+
+/**
+ * Server stopped by SIGINT/SIGTERM
+ */
+inline std::atomic<CipherServer*> signalled_server{nullptr};
+
+/**
+ * --serve: runs the socket server until interrupted
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runServe(const CliOptions& options) {
+#if CIPHERSUITE_HAS_SERVER
+    try {
+        CipherServer server(openSocket(options.serve, true), {.workers = options.threads_set ? options.threads : hardwareThreads()});
+        signalled_server.store(&server);
+        const auto stop = [](int) { if (CipherServer* const s = signalled_server.load()) { s->stop(); } };
+        std::signal(SIGINT, stop);
+        std::signal(SIGTERM, stop);
+        std::println(stderr, "Listening on {}", options.serve);
+        server.run();
+        signalled_server.store(nullptr);
+    }
+    catch (const std::exception& e) {
+        signalled_server.store(nullptr);
+        std::println(stderr, "Server failed: {}", e.what());
+        return 1;
+    }
+    if (options.serve.starts_with("unix:")) {
+        ::unlink(options.serve.c_str() + 5);
+    }
+    return 0;
+#else
+    (void)options;
+    std::println(stderr, "--serve is not supported on this platform");
+    return 1;
+#endif
+}
+
+/**
+ * --connect: sends the whole input to a server and writes the reply
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runConnect(const CliOptions& options) {
+#if CIPHERSUITE_HAS_SERVER
+    std::ifstream file_in;
+    if (options.input != "-") {
+        file_in.open(options.input, std::ios::binary);
+        if (not file_in) {
+            std::println(stderr, "Cannot open input '{}'", options.input);
+            return 1;
+        }
+    }
+    std::istream& in = file_in.is_open() ? static_cast<std::istream&>(file_in) : std::cin;
+    const std::string payload(std::istreambuf_iterator<char>(in), {});
+    if (in.bad()) {
+        std::println(stderr, "I/O error while reading");
+        return 1;
+    }
+
+    ServerResponse response;
+    try {
+        CipherClient client(options.connect);
+        response = client.call(ServerRequest{.direction = *options.direction, .cipher = *options.cipher, .key = options.key, .payload = payload});
+    }
+    catch (const std::exception& e) {
+        std::println(stderr, "Request failed: {}", e.what());
+        return 1;
+    }
+    if (response.status != ServerStatus::ok) {
+        std::println(stderr, "Server rejected the request (status {})", static_cast<unsigned>(response.status));
+        return 1;
+    }
+
+    std::ofstream file_out;
+    if (options.output != "-") {
+        file_out.open(options.output, std::ios::binary | std::ios::trunc);
+        if (not file_out) {
+            std::println(stderr, "Cannot open output '{}'", options.output);
+            return 1;
+        }
+    }
+    std::ostream& out = file_out.is_open() ? static_cast<std::ostream&>(file_out) : std::cout;
+    out.write(response.payload.data(), static_cast<std::streamsize>(response.payload.size()));
+    out.flush();
+    if (not out) {
+        std::println(stderr, "I/O error while writing");
+        return 1;
+    }
+    return 0;
+#else
+    (void)options;
+    std::println(stderr, "--connect is not supported on this platform");
+    return 1;
+#endif
+}
+
+/**
+ * --crack: recovers the key from the whole input and prints it
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runCrack(const CliOptions& options) {
+    std::ifstream file_in;
+    if (options.input != "-") {
+        file_in.open(options.input, std::ios::binary);
+        if (not file_in) {
+            std::println(stderr, "Cannot open input '{}'", options.input);
+            return 1;
+        }
+    }
+    std::istream& in = file_in.is_open() ? static_cast<std::istream&>(file_in) : std::cin;
+    const std::string ciphertext(std::istreambuf_iterator<char>(in), {});
+    if (in.bad()) {
+        std::println(stderr, "I/O error while reading");
+        return 1;
+    }
+
+    if (*options.cipher == CipherId::caesar) {
+        std::println("{}", crackCaesar(ciphertext).key);
+    }
+    else {
+        std::println("{}", crackVigenere(ciphertext).key);
+    }
+    return 0;
+}
+
+/**
+ * Encrypt/decrypt modes: builds the cipher and picks the driver
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runTransform(const CliOptions& options) {
+    std::unique_ptr<Encryption> cipher = options.cipher ? makeCipher(*options.cipher, options.key) : parsePipeline(options.chain);
+    if (not cipher) {
+        if (not options.cipher) {
+            std::println(stderr, "Invalid --chain '{}'", options.chain);
+        }
+        else if (needsKey(*options.cipher)) {
+            std::println(stderr, "Invalid or missing --key");
+        }
+        else {
+            std::println(stderr, "Could not create cipher");
+        }
+        return 1;
+    }
+    if (options.offload) {
+        if (not OffloadCipher::supports(*cipher)) {
+            std::println(stderr, "--offload supports caesar, vigenere, atbash and chains of them only");
+            return 1;
+        }
+        if (not offloadDeviceName()) {
+            std::println(stderr, "--offload: no OpenCL device found, running on the CPU");
+        }
+        cipher = std::make_unique<OffloadCipher>(std::shared_ptr<const Encryption>(std::move(cipher)));
+    }
+
+    if (not options.batch.empty()) {
+        return runBatch(*cipher, options);
+    }
+
+    // Multithreaded runs read enough per chunk to give every thread work
+    std::optional<ThreadPool> pool;
+    std::size_t chunk_size = options.chunk_size;
+    if (options.threads > 1) {
+        pool.emplace(options.threads - 1);
+        if (not options.chunk_size_set) {
+            chunk_size = options.threads * PARALLEL_CHUNK_SIZE;
+        }
+    }
+    // Chunks below the threshold would never leave the CPU
+    if (options.offload and not options.chunk_size_set) {
+        chunk_size = std::max(chunk_size, 2 * OFFLOAD_MIN_BYTES);
+    }
+
+    if (options.container) {
+        return runContainer(*cipher, options, pool ? &*pool : nullptr);
+    }
+    if (options.range_offset) {
+        return runRange(*cipher, options);
+    }
+    if (options.mapped or options.in_place) {
+        return runMapped(*cipher, options, pool ? &*pool : nullptr);
+    }
+    if (options.async) {
+        return runAsync(*cipher, options, chunk_size, pool ? &*pool : nullptr);
+    }
+
+    std::ifstream file_in;
+    if (options.input != "-") {
+        file_in.open(options.input, std::ios::binary);
+        if (not file_in) {
+            std::println(stderr, "Cannot open input '{}'", options.input);
+            return 1;
+        }
+    }
+    std::ofstream file_out;
+    if (options.output != "-") {
+        file_out.open(options.output, std::ios::binary | std::ios::trunc);
+        if (not file_out) {
+            std::println(stderr, "Cannot open output '{}'", options.output);
+            return 1;
+        }
+    }
+
+    std::istream& in = file_in.is_open() ? static_cast<std::istream&>(file_in) : std::cin;
+    std::ostream& out = file_out.is_open() ? static_cast<std::ostream&>(file_out) : std::cout;
+    if (not streamTransform(*cipher, *options.direction, in, out, chunk_size, pool ? &*pool : nullptr)) {
+        std::println(stderr, "I/O error while streaming");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Entry point for the flag-driven mode
+ * @return Process exit status
+ */
+[[nodiscard]] inline int runCli(const int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    const auto options = parseArgs(argc, argv);
+    if (not options) {
+        return 1;
+    }
+
+    int status = 0;
+    if (not options->serve.empty()) {
+        status = runServe(*options);
+    }
+    else if (not options->connect.empty()) {
+        status = runConnect(*options);
+    }
+    else {
+        status = options->crack ? runCrack(*options) : runTransform(*options);
+    }
+    if (options->stats) {
+        std::print(stderr, "{}", stats::format(stats::registry().snapshot(), options->stats_format));
+    }
+    return status;
+}
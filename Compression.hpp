@@ -0,0 +1,248 @@
+/**
+ * @file Compression.hpp
+ * @brief LZ4 Block Compression
+ *
+ * Self-contained encoder and decoder for the LZ4 block format, so blocks
+ * written here can be read by any LZ4 implementation (LZ4_decompress_safe)
+ * and the other way round, without linking liblz4.
+ *
+ * Features:
+ * - Greedy single-probe hash matcher: fast rather than tight, which suits
+ *   text and is the same trade-off as LZ4's default level
+ * - Decoder validates every length and offset against both buffers, so
+ *   corrupt or wrongly deciphered input is reported, never overrun
+ * - No allocation: callers provide both buffers (see compressBound())
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<algorithm>
+#include<array>
+#include<bit>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<optional>
+#include<span>
+
+
+namespace lz4 {
+
+inline constexpr std::size_t MIN_MATCH = 4;
+inline constexpr std::size_t LAST_LITERALS = 5;   // a block always ends with this many literals
+inline constexpr std::size_t MATCH_LIMIT = 12;    // no match may start in the last 12 bytes
+inline constexpr std::size_t MAX_OFFSET = 65535;
+inline constexpr unsigned HASH_BITS = 14;
+
+/**
+ * Output size that is enough for any n bytes of input
+ */
+[[nodiscard]] constexpr std::size_t compressBound(const std::size_t n) noexcept{
+    return n + n / 255 + 16;
+}
+
+namespace detail {
+
+[[nodiscard]] inline std::uint32_t load32(const unsigned char* const p) noexcept{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+[[nodiscard]] inline std::uint64_t load64(const unsigned char* const p) noexcept{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+/**
+ * Length of the common prefix of a and b, stopping at limit (b < limit)
+ */
+[[nodiscard]] inline std::size_t commonLength(const unsigned char* a, const unsigned char* b, const unsigned char* const limit) noexcept{
+    const unsigned char* const start = b;
+    while (b + 8 <= limit) {
+        const std::uint64_t diff = load64(a) ^ load64(b);
+        if (diff != 0) {
+            return static_cast<std::size_t>(b - start) + static_cast<std::size_t>(std::countr_zero(diff) >> 3);
+        }
+        a += 8;
+        b += 8;
+    }
+    while (b < limit and *a == *b) {
+        ++a;
+        ++b;
+    }
+    return static_cast<std::size_t>(b - start);
+}
+
+[[nodiscard]] inline std::uint32_t hash(const std::uint32_t v) noexcept{
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * Writes the 255-run extension of a length field that overflowed its
+ * nibble
+ */
+inline unsigned char* putLength(unsigned char* op, std::size_t length) noexcept{
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+inline unsigned char* putSequence(unsigned char* op, const unsigned char* const literals, const std::size_t literal_count,
+    const std::size_t offset, const std::size_t match_length) noexcept{
+    unsigned char* const token = op++;
+    *token = static_cast<unsigned char>(std::min<std::size_t>(literal_count, 15) << 4);
+    if (literal_count >= 15) {
+        op = putLength(op, literal_count - 15);
+    }
+    std::memcpy(op, literals, literal_count);
+    op += literal_count;
+    if (match_length == 0) {
+        return op;
+    }
+    *op++ = static_cast<unsigned char>(offset);
+    *op++ = static_cast<unsigned char>(offset >> 8);
+    const std::size_t extra = match_length - MIN_MATCH;
+    *token |= static_cast<unsigned char>(std::min<std::size_t>(extra, 15));
+    if (extra >= 15) {
+        op = putLength(op, extra - 15);
+    }
+    return op;
+}
+
+/**
+ * Reads a length field, adding its 255-run extension when the nibble is
+ * saturated
+ */
+[[nodiscard]] inline bool getLength(const std::span<const unsigned char> in, std::size_t& ip, std::size_t& length) noexcept{
+    if (length != 15) {
+        return true;
+    }
+    for (;;) {
+        if (ip == in.size()) {
+            return false;
+        }
+        const unsigned char b = in[ip++];
+        length += b;
+        if (b != 255) {
+            return true;
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * Compresses in into out
+ * @param out At least compressBound(in.size()) bytes
+ * @return Bytes written
+ */
+inline std::size_t compress(const std::span<const char> in, const std::span<char> out) noexcept{
+    const auto* const src = reinterpret_cast<const unsigned char*>(in.data());
+    auto* const dst = reinterpret_cast<unsigned char*>(out.data());
+    const std::size_t n = in.size();
+    unsigned char* op = dst;
+    std::size_t anchor = 0;
+
+    if (n > MATCH_LIMIT) {
+        std::array<std::uint32_t, std::size_t{1} << HASH_BITS> table{};
+        const std::size_t limit = n - MATCH_LIMIT;
+        const std::size_t match_end = n - LAST_LITERALS;
+        std::size_t ip = 1;
+        while (ip < limit) {
+            const std::uint32_t sequence = detail::load32(src + ip);
+            std::uint32_t& slot = table[detail::hash(sequence)];
+            std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(ip);
+            if (ip - candidate > MAX_OFFSET or candidate >= ip or detail::load32(src + candidate) != sequence) {
+                // Step faster through data that keeps missing
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            while (ip > anchor and candidate > 0 and src[ip - 1] == src[candidate - 1]) {
+                --ip;
+                --candidate;
+            }
+            const std::size_t length = MIN_MATCH + detail::commonLength(src + candidate + MIN_MATCH, src + ip + MIN_MATCH, src + match_end);
+            op = detail::putSequence(op, src + anchor, ip - anchor, ip - candidate, length);
+            ip += length;
+            anchor = ip;
+            if (ip < limit) {
+                table[detail::hash(detail::load32(src + ip - 2))] = static_cast<std::uint32_t>(ip - 2);
+            }
+        }
+    }
+    op = detail::putSequence(op, src + anchor, n - anchor, 0, 0);
+    return static_cast<std::size_t>(op - dst);
+}
+
+/**
+ * Decompresses in into out, which must be exactly the original size
+ * @return Bytes written, or nullopt if in is not a valid block for out
+ */
+[[nodiscard]] inline std::optional<std::size_t> decompress(const std::span<const char> in, const std::span<char> out) noexcept{
+    const std::span<const unsigned char> src(reinterpret_cast<const unsigned char*>(in.data()), in.size());
+    auto* const dst = reinterpret_cast<unsigned char*>(out.data());
+    std::size_t ip = 0;
+    std::size_t op = 0;
+    for (;;) {
+        if (ip == src.size()) {
+            return std::nullopt;
+        }
+        const unsigned char token = src[ip++];
+        std::size_t literals = token >> 4;
+        if (not detail::getLength(src, ip, literals) or literals > src.size() - ip or literals > out.size() - op) {
+            return std::nullopt;
+        }
+        if (literals <= 16 and src.size() - ip >= 16 and out.size() - op >= 16) {
+            std::memcpy(dst + op, src.data() + ip, 16);   // fixed size: one vector move
+        }
+        else {
+            std::memcpy(dst + op, src.data() + ip, literals);
+        }
+        ip += literals;
+        op += literals;
+        if (ip == src.size()) {
+            return op;
+        }
+
+        if (src.size() - ip < 2) {
+            return std::nullopt;
+        }
+        const std::size_t offset = src[ip] | std::size_t{src[ip + 1]} << 8;
+        ip += 2;
+        std::size_t length = token & 15;
+        if (offset == 0 or offset > op or not detail::getLength(src, ip, length)) {
+            return std::nullopt;
+        }
+        length += MIN_MATCH;
+        if (length > out.size() - op) {
+            return std::nullopt;
+        }
+        if (offset >= 8 and out.size() - op >= length + 8) {
+            // Each 8-byte step reads only bytes already written, and may
+            // run up to 7 bytes past the match into space still to be filled
+            for (std::size_t i = 0; i < length; i += 8) {
+                std::memcpy(dst + op + i, dst + op + i - offset, 8);
+            }
+        }
+        else if (offset >= length) {
+            std::memcpy(dst + op, dst + op - offset, length);
+        }
+        else {
+            // Overlapping match: a run repeating the last offset bytes
+            for (std::size_t i = 0; i < length; ++i) {
+                dst[op + i] = dst[op + i - offset];
+            }
+        }
+        op += length;
+    }
+}
+
+} // namespace lz4
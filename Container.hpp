@@ -0,0 +1,432 @@
+/**
+ * @file Container.hpp
+ * @brief Compressed, Block-Indexed Ciphertext Container
+ *
+ * Long-term storage format: the plaintext is cut into fixed-size blocks,
+ * each block is compressed on its own (LZ4, see Compression.hpp) and then
+ * enciphered. Compressing first is what makes the saving possible, since
+ * ciphertext of these ciphers compresses no better than the plaintext
+ * does after a key-dependent shift.
+ *
+ * Layout (all integers little-endian):
+ *   header   64 bytes   magic "CSBC", version, cipher name, key-phase
+ *                       mode, block size, plaintext size, block count
+ *   index    32 bytes   per block: file offset, stored size, plaintext
+ *                       size, codec, FNV-1a checksum of the plaintext
+ *   blocks              stored bytes of every block, in order
+ *
+ * Key phase: every block is enciphered as the bytes at its own file offset,
+ * so the stored block is exactly what transformFileRange() decrypts in
+ * place (the offset in the index doubles as the block's key phase). One
+ * block can therefore be read, deciphered and decompressed on its own.
+ *
+ * Features:
+ * - Writing and reading run block-parallel on a ThreadPool, a bounded
+ *   wave of blocks at a time
+ * - Incompressible blocks are stored raw, so output never grows by more
+ *   than the index
+ * - Plaintext ranges read only the blocks they touch
+ * - Checksums catch corruption and the wrong key, before any output
+ *
+ * Length-preserving ciphers only (Caesar, Vigenère, Atbash and chains of
+ * them): they map any bytes, compressed ones included, one to one.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Compression.hpp"
+#include "Encryptions.hpp"
+#include "RandomAccess.hpp"
+#include "Stats.hpp"
+#include "ThreadPool.hpp"
+#include<algorithm>
+#include<atomic>
+#include<cerrno>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<fstream>
+#include<limits>
+#include<ostream>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<system_error>
+#include<vector>
+
+
+/**
+ * Plaintext bytes per block by default: large enough for a good ratio,
+ * small enough that a random read decompresses little
+ */
+inline constexpr std::size_t CONTAINER_BLOCK_SIZE = std::size_t{1} << 20;
+
+enum class Codec : std::uint8_t { stored = 0, lz4 = 1 };
+
+struct ContainerOptions {
+    std::size_t block_size = CONTAINER_BLOCK_SIZE;
+    Codec codec = Codec::lz4;
+};
+
+struct ContainerBlock {
+    std::uint64_t offset = 0;       // in the file; also the key phase
+    std::uint64_t checksum = 0;     // FNV-1a of the plaintext
+    std::uint32_t stored_size = 0;
+    std::uint32_t plain_size = 0;
+    Codec codec = Codec::stored;
+};
+
+struct ContainerInfo {
+    std::string cipher;
+    std::size_t block_size = 0;
+    std::uint64_t plain_size = 0;
+    std::vector<ContainerBlock> blocks;
+
+    /**
+     * Size of the whole container file
+     */
+    [[nodiscard]] std::uint64_t fileSize() const noexcept{
+        return blocks.empty() ? payloadOffset() : blocks.back().offset + blocks.back().stored_size;
+    }
+
+    [[nodiscard]] std::uint64_t payloadOffset() const noexcept;
+};
+
+namespace detail {
+
+inline constexpr char CONTAINER_MAGIC[4] = {'C', 'S', 'B', 'C'};
+inline constexpr std::uint16_t CONTAINER_VERSION = 1;
+inline constexpr std::size_t CONTAINER_HEADER_SIZE = 64;
+inline constexpr std::size_t CONTAINER_ENTRY_SIZE = 32;
+inline constexpr std::size_t CONTAINER_NAME_SIZE = 16;
+inline constexpr std::uint8_t PHASE_FILE_OFFSET = 1;   // blocks keyed at their file offset
+
+template<typename T>
+void putLe(char* const p, T value) noexcept{
+    for (std::size_t i = 0; i < sizeof(T); ++i, value >>= 8) {
+        p[i] = static_cast<char>(value & 0xFF);
+    }
+}
+
+template<typename T>
+[[nodiscard]] T getLe(const char* const p) noexcept{
+    T value = 0;
+    for (std::size_t i = sizeof(T); i-- > 0;) {
+        value = static_cast<T>(value << 8 | static_cast<unsigned char>(p[i]));
+    }
+    return value;
+}
+
+[[nodiscard]] inline std::uint64_t fnv1a(const std::span<const char> data) noexcept{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : data) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+[[noreturn]] inline void corrupt(const std::string& what) {
+    throw std::runtime_error("container: " + what);
+}
+
+/**
+ * Blocks handled per parallel wave; bounds memory to a few blocks a thread
+ */
+[[nodiscard]] inline std::size_t waveBlocks(const ThreadPool& pool) noexcept{
+    return std::size_t{pool.concurrency()} * 2;
+}
+
+inline void requireStorableCipher(const Encryption& cipher) {
+    if (not cipher.preservesLength()) {
+        throw std::logic_error("container: cipher does not preserve length");
+    }
+}
+
+inline void requireSameCipher(const ContainerInfo& info, const Encryption& cipher) {
+    if (info.cipher != cipher.name()) {
+        throw std::invalid_argument("container: written with cipher '" + info.cipher + "', not '" + std::string(cipher.name()) + "'");
+    }
+}
+
+[[nodiscard]] inline std::vector<char> encodeHeader(const ContainerInfo& info) {
+    std::vector<char> head(info.payloadOffset(), '\0');
+    std::memcpy(head.data(), CONTAINER_MAGIC, sizeof CONTAINER_MAGIC);
+    putLe<std::uint16_t>(head.data() + 4, CONTAINER_VERSION);
+    putLe<std::uint16_t>(head.data() + 6, CONTAINER_HEADER_SIZE);
+    std::memcpy(head.data() + 8, info.cipher.data(), std::min(info.cipher.size(), CONTAINER_NAME_SIZE));
+    head[24] = static_cast<char>(PHASE_FILE_OFFSET);
+    putLe<std::uint32_t>(head.data() + 28, static_cast<std::uint32_t>(info.block_size));
+    putLe<std::uint64_t>(head.data() + 32, info.plain_size);
+    putLe<std::uint64_t>(head.data() + 40, info.blocks.size());
+    for (std::size_t k = 0; k < info.blocks.size(); ++k) {
+        const ContainerBlock& block = info.blocks[k];
+        char* const entry = head.data() + CONTAINER_HEADER_SIZE + k * CONTAINER_ENTRY_SIZE;
+        putLe<std::uint64_t>(entry, block.offset);
+        putLe<std::uint64_t>(entry + 8, block.checksum);
+        putLe<std::uint32_t>(entry + 16, block.stored_size);
+        putLe<std::uint32_t>(entry + 20, block.plain_size);
+        entry[24] = static_cast<char>(block.codec);
+    }
+    return head;
+}
+
+/**
+ * Deciphered stored bytes -> plaintext, verified against the index
+ */
+[[nodiscard]] inline bool decodeBlock(const ContainerBlock& block, const std::span<const char> stored, const std::span<char> plain) noexcept{
+    if (block.codec == Codec::stored) {
+        std::memcpy(plain.data(), stored.data(), stored.size());
+    }
+    else if (const auto size = lz4::decompress(stored, plain); not size or *size != plain.size()) {
+        return false;
+    }
+    return fnv1a(plain) == block.checksum;
+}
+
+} // namespace detail
+
+inline std::uint64_t ContainerInfo::payloadOffset() const noexcept{
+    return detail::CONTAINER_HEADER_SIZE + blocks.size() * detail::CONTAINER_ENTRY_SIZE;
+}
+
+/**
+ * Compresses and enciphers in into a new container file
+ * @param cipher Configured length-preserving cipher
+ * @param in Plaintext
+ * @param path Container to create (truncated if it exists)
+ * @param pool Threads to compress and encipher on
+ * @return The header and index as written
+ * @throws std::logic_error if the cipher changes the length
+ * @throws std::invalid_argument for a block size of 0 or over 4 GiB
+ * @throws std::system_error if the file cannot be written
+ */
+inline ContainerInfo writeContainer(const Encryption& cipher, const std::span<const char> in, const std::string& path,
+    ThreadPool& pool = sharedThreadPool(), const ContainerOptions& options = {}) {
+    detail::requireStorableCipher(cipher);
+    if (options.block_size == 0 or lz4::compressBound(options.block_size) > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("container: block size out of range");
+    }
+    ContainerInfo info{std::string(cipher.name()), options.block_size, in.size(), {}};
+    info.blocks.resize((in.size() + options.block_size - 1) / options.block_size);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (not file) {
+        throw std::system_error(errno, std::generic_category(), "create '" + path + "'");
+    }
+    // The index is only known once every block is compressed: reserve it
+    // now and fill it in at the end
+    const std::vector<char> placeholder(info.payloadOffset(), '\0');
+    file.write(placeholder.data(), static_cast<std::streamsize>(placeholder.size()));
+
+    const std::size_t wave = detail::waveBlocks(pool);
+    std::vector<std::vector<char>> scratch(std::min(wave, info.blocks.size()));
+    std::uint64_t position = info.payloadOffset();
+    for (std::size_t first = 0; first < info.blocks.size(); first += wave) {
+        const std::size_t count = std::min(wave, info.blocks.size() - first);
+        pool.parallelFor(count, [&](const std::size_t j) {
+            ContainerBlock& block = info.blocks[first + j];
+            const std::span<const char> plain = in.subspan((first + j) * options.block_size,
+                std::min<std::size_t>(options.block_size, in.size() - (first + j) * options.block_size));
+            std::vector<char>& buffer = scratch[j];
+            buffer.resize(lz4::compressBound(plain.size()));
+            std::size_t stored = options.codec == Codec::lz4 ? lz4::compress(plain, buffer) : plain.size();
+            block.codec = Codec::lz4;
+            if (options.codec == Codec::stored or stored >= plain.size()) {
+                std::memcpy(buffer.data(), plain.data(), plain.size());
+                stored = plain.size();
+                block.codec = Codec::stored;
+            }
+            block.plain_size = static_cast<std::uint32_t>(plain.size());
+            block.stored_size = static_cast<std::uint32_t>(stored);
+            block.checksum = detail::fnv1a(plain);
+        });
+        for (std::size_t j = 0; j < count; ++j) {
+            info.blocks[first + j].offset = position;
+            position += info.blocks[first + j].stored_size;
+        }
+        pool.parallelFor(count, [&](const std::size_t j) {
+            const ContainerBlock& block = info.blocks[first + j];
+            cipher.transformInPlace(std::span(scratch[j].data(), block.stored_size), Direction::encrypt, block.offset);
+        });
+
+        stats::IoTimer timer;
+        for (std::size_t j = 0; j < count; ++j) {
+            file.write(scratch[j].data(), info.blocks[first + j].stored_size);
+        }
+        timer.record(stats::IoOp::write, position - info.blocks[first].offset);
+    }
+
+    const std::vector<char> head = detail::encodeHeader(info);
+    file.seekp(0);
+    file.write(head.data(), static_cast<std::streamsize>(head.size()));
+    file.close();
+    if (not file) {
+        throw std::system_error(errno, std::generic_category(), "write '" + path + "'");
+    }
+    return info;
+}
+
+/**
+ * Reads and validates the header and index of a container
+ * @throws std::system_error if the file cannot be opened or read
+ * @throws std::runtime_error if it is not a well-formed container
+ */
+[[nodiscard]] inline ContainerInfo readContainerInfo(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (not file) {
+        throw std::system_error(errno, std::generic_category(), "open '" + path + "'");
+    }
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+    std::vector<char> head(detail::CONTAINER_HEADER_SIZE);
+    if (file_size < head.size() or not file.read(head.data(), static_cast<std::streamsize>(head.size()))) {
+        detail::corrupt("'" + path + "' is too short");
+    }
+    if (std::memcmp(head.data(), detail::CONTAINER_MAGIC, sizeof detail::CONTAINER_MAGIC) != 0) {
+        detail::corrupt("'" + path + "' is not a container");
+    }
+    if (detail::getLe<std::uint16_t>(head.data() + 4) != detail::CONTAINER_VERSION
+        or detail::getLe<std::uint16_t>(head.data() + 6) != detail::CONTAINER_HEADER_SIZE
+        or static_cast<std::uint8_t>(head[24]) != detail::PHASE_FILE_OFFSET) {
+        detail::corrupt("unsupported version in '" + path + "'");
+    }
+
+    ContainerInfo info;
+    const std::string_view name(head.data() + 8, detail::CONTAINER_NAME_SIZE);
+    info.cipher = name.substr(0, name.find('\0'));
+    info.block_size = detail::getLe<std::uint32_t>(head.data() + 28);
+    info.plain_size = detail::getLe<std::uint64_t>(head.data() + 32);
+    const std::uint64_t count = detail::getLe<std::uint64_t>(head.data() + 40);
+    if (info.block_size == 0 or count != (info.plain_size + info.block_size - 1) / info.block_size
+        or count > (file_size - detail::CONTAINER_HEADER_SIZE) / detail::CONTAINER_ENTRY_SIZE) {
+        detail::corrupt("bad header in '" + path + "'");
+    }
+
+    std::vector<char> index(count * detail::CONTAINER_ENTRY_SIZE);
+    if (not file.read(index.data(), static_cast<std::streamsize>(index.size()))) {
+        detail::corrupt("truncated index in '" + path + "'");
+    }
+    info.blocks.resize(count);
+    std::uint64_t position = info.payloadOffset();
+    for (std::size_t k = 0; k < count; ++k) {
+        const char* const entry = index.data() + k * detail::CONTAINER_ENTRY_SIZE;
+        ContainerBlock& block = info.blocks[k];
+        block.offset = detail::getLe<std::uint64_t>(entry);
+        block.checksum = detail::getLe<std::uint64_t>(entry + 8);
+        block.stored_size = detail::getLe<std::uint32_t>(entry + 16);
+        block.plain_size = detail::getLe<std::uint32_t>(entry + 20);
+        block.codec = static_cast<Codec>(entry[24]);
+        const std::uint64_t expected = k + 1 < count ? info.block_size : info.plain_size - k * info.block_size;
+        const bool valid_codec = block.codec == Codec::lz4 ? block.stored_size <= lz4::compressBound(block.plain_size)
+            : block.codec == Codec::stored and block.stored_size == block.plain_size;
+        if (block.offset != position or block.plain_size != expected or not valid_codec) {
+            detail::corrupt("bad index entry " + std::to_string(k) + " in '" + path + "'");
+        }
+        position += block.stored_size;
+    }
+    if (position > file_size) {
+        detail::corrupt("'" + path + "' is truncated");
+    }
+    return info;
+}
+
+/**
+ * Decrypts and decompresses block k of a container on its own
+ * @param info The container's readContainerInfo()
+ * @throws std::runtime_error if the block is corrupt or the key is wrong
+ */
+[[nodiscard]] inline std::string readContainerBlock(const Encryption& cipher, const std::string& path, const ContainerInfo& info, const std::size_t k) {
+    detail::requireSameCipher(info, cipher);
+    const ContainerBlock& block = info.blocks.at(k);
+    const std::string stored = decryptFileRange(cipher, path, block.offset, block.stored_size);
+    std::string plain(block.plain_size, '\0');
+    if (stored.size() != block.stored_size or not detail::decodeBlock(block, stored, plain)) {
+        detail::corrupt("block " + std::to_string(k) + " is corrupt or the key is wrong");
+    }
+    return plain;
+}
+
+/**
+ * Plaintext bytes [offset, offset + length) of a container, reading only
+ * the blocks they fall in; clipped to the end like transformFileRange()
+ */
+[[nodiscard]] inline std::string readContainerRange(const Encryption& cipher, const std::string& path, const std::uint64_t offset, const std::uint64_t length) {
+    const ContainerInfo info = readContainerInfo(path);
+    const std::uint64_t begin = std::min(offset, info.plain_size);
+    const std::uint64_t end = begin + std::min(length, info.plain_size - begin);
+    std::string range;
+    range.reserve(end - begin);
+    for (std::uint64_t k = begin / info.block_size; k * info.block_size < end; ++k) {
+        const std::string plain = readContainerBlock(cipher, path, info, k);
+        const std::uint64_t from = std::max(begin, k * info.block_size) - k * info.block_size;
+        const std::uint64_t to = std::min(end, k * info.block_size + plain.size()) - k * info.block_size;
+        range.append(plain, from, to - from);
+    }
+    return range;
+}
+
+/**
+ * Decrypts and decompresses a whole container into out
+ * @param pool Threads to decipher and decompress on
+ * @return Plaintext bytes written
+ * @throws std::invalid_argument if it was written with another cipher
+ * @throws std::runtime_error if a block is corrupt or the key is wrong;
+ *         blocks before it have already been written
+ * @throws std::system_error if the file cannot be read or out fails
+ */
+inline std::uint64_t unpackContainer(const Encryption& cipher, const std::string& path, std::ostream& out, ThreadPool& pool = sharedThreadPool()) {
+    detail::requireStorableCipher(cipher);
+    const ContainerInfo info = readContainerInfo(path);
+    detail::requireSameCipher(info, cipher);
+    std::ifstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::system_error(errno, std::generic_category(), "open '" + path + "'");
+    }
+    file.seekg(static_cast<std::streamoff>(info.payloadOffset()));
+
+    const std::size_t wave = detail::waveBlocks(pool);
+    std::vector<char> stored;
+    std::vector<char> plain;
+    for (std::size_t first = 0; first < info.blocks.size(); first += wave) {
+        const std::size_t count = std::min(wave, info.blocks.size() - first);
+        const ContainerBlock& last = info.blocks[first + count - 1];
+        const std::uint64_t base = info.blocks[first].offset;
+        stored.resize(last.offset + last.stored_size - base);
+        plain.resize(std::size_t{count} * info.block_size);
+
+        stats::IoTimer timer;
+        if (not file.read(stored.data(), static_cast<std::streamsize>(stored.size()))) {
+            throw std::system_error(errno ? errno : EIO, std::generic_category(), "read '" + path + "'");
+        }
+        timer.record(stats::IoOp::read, stored.size());
+
+        std::atomic<std::size_t> failed{info.blocks.size()};
+        pool.parallelFor(count, [&](const std::size_t j) {
+            const ContainerBlock& block = info.blocks[first + j];
+            const std::span<char> bytes(stored.data() + (block.offset - base), block.stored_size);
+            cipher.transformInPlace(bytes, Direction::decrypt, block.offset);
+            if (not detail::decodeBlock(block, bytes, std::span(plain.data() + j * info.block_size, block.plain_size))) {
+                // Report the first bad block, whichever thread finds it
+                std::size_t expected = failed.load();
+                while (first + j < expected and not failed.compare_exchange_weak(expected, first + j)) {}
+            }
+        });
+        if (failed.load() != info.blocks.size()) {
+            detail::corrupt("block " + std::to_string(failed.load()) + " is corrupt or the key is wrong");
+        }
+
+        const std::size_t bytes = (count - 1) * info.block_size + last.plain_size;
+        stats::IoTimer write_timer;
+        out.write(plain.data(), static_cast<std::streamsize>(bytes));
+        write_timer.record(stats::IoOp::write, bytes);
+        if (not out) {
+            throw std::system_error(errno ? errno : EIO, std::generic_category(), "write");
+        }
+    }
+    out.flush();
+    return info.plain_size;
+}
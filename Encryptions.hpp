@@ -3,8 +3,9 @@
  * @brief Abstract Base Class for Cryptographic Algorithms
  * 
  * This header defines the base interface for all encryption algorithms
- * in the suite. It provides a common interface that ensures all ciphers
- * implement the required encryption and decryption methods.
+ * in the suite. A cipher object holds only its key and configuration;
+ * messages live in caller-owned buffers, so one configured cipher is
+ * immutable in use and can be shared by any number of threads.
  * 
  * Design Pattern: Template Method Pattern
  * - Defines the algorithm structure in the base class
@@ -12,7 +13,15 @@
  * - Ensures consistent interface across all algorithms
  * 
  * Features:
- * - Pure virtual functions for encrypt/decrypt operations
+ * - Pure virtual span kernel, wrapped by checked public entry points
+ * - Stateless span-based transform() for caller-owned buffers
+ * - In-place transform for length-preserving ciphers
+ * - Owning encrypt()/decrypt() returning a fresh string, optionally
+ *   allocated from a caller's std::pmr::memory_resource (arena, pool)
+ * - Random-access decryptRange() for length-preserving ciphers
+ * - Thread-local scratch output for allocation-free owning-style calls
+ * - Per-object SIMD level (defaults to the best the CPU supports)
+ * - Optional per-cipher call/byte/time counters (see Stats.hpp)
  * - RAII-compliant resource management
  * - Exception-safe string operations
  * - Move semantics for efficient data transfer
@@ -23,23 +32,243 @@
  */
 
 #pragma once
+#include "Simd.hpp"
+#include "Stats.hpp"
+#include<algorithm>
+#include<cstddef>
+#include<memory_resource>
+#include<span>
+#include<stdexcept>
 #include<string>
-#include<utility>
+#include<string_view>
+
+/**
+ * Direction of a transform, for drivers that choose between encrypt()
+ * and decrypt() at runtime (CLI flags, streaming)
+ */
+enum class Direction { encrypt, decrypt };
 
 class Encryption {
     protected:
-        std::string message;
-        std::string encrypted_message;
+        SimdLevel simd_level = bestSimdLevel();
     public:
-        void setMessage(std::string m) noexcept{
-            message = std::move(m);
+        virtual ~Encryption() = default;
+
+        /**
+         * Encrypts message into a new string
+         * @param offset Position of message[0] within the overall stream
+         *               (only Vigenère depends on it)
+         */
+        [[nodiscard]] std::string encrypt(const std::string_view message, const std::size_t offset = 0) const{
+            return apply(message, Direction::encrypt, offset);
         }
-        [[nodiscard]] const std::string& getEncryptedMessage() const noexcept{
-            return encrypted_message;
+
+        /**
+         * Decrypts message into a new string
+         * @param offset Position of message[0] within the overall stream
+         */
+        [[nodiscard]] std::string decrypt(const std::string_view message, const std::size_t offset = 0) const{
+            return apply(message, Direction::decrypt, offset);
         }
-        virtual void encrypt() = 0;
-        virtual void decrypt() = 0;
-        virtual ~Encryption() = default;
 
-};
+        /**
+         * Transforms message in the given direction into a new string
+         */
+        [[nodiscard]] std::string apply(const std::string_view message, const Direction d, const std::size_t offset = 0) const{
+            stats::TransformTimer timer(*this, message.size());
+            std::string result(transformedSize(message, d, offset), '\0');
+            if (result.size() > std::string().capacity()) {
+                timer.allocated();
+            }
+            timer.produced(transformSpan(message, result, d, offset));
+            return result;
+        }
+
+        /**
+         * Encrypts message into a string allocated from resource, e.g. a
+         * per-request std::pmr::monotonic_buffer_resource released in one go
+         */
+        [[nodiscard]] std::pmr::string encrypt(const std::string_view message, std::pmr::memory_resource& resource, const std::size_t offset = 0) const{
+            return apply(message, Direction::encrypt, resource, offset);
+        }
+
+        /**
+         * Decrypts message into a string allocated from resource
+         */
+        [[nodiscard]] std::pmr::string decrypt(const std::string_view message, std::pmr::memory_resource& resource, const std::size_t offset = 0) const{
+            return apply(message, Direction::decrypt, resource, offset);
+        }
+
+        /**
+         * Transforms message into a string allocated from resource; the
+         * only allocation is the result itself
+         */
+        [[nodiscard]] std::pmr::string apply(const std::string_view message, const Direction d, std::pmr::memory_resource& resource, const std::size_t offset = 0) const{
+            stats::TransformTimer timer(*this, message.size());
+            std::pmr::string result(transformedSize(message, d, offset), '\0', &resource);
+            if (result.size() > std::pmr::string().capacity()) {
+                timer.allocated();
+            }
+            timer.produced(transformSpan(message, result, d, offset));
+            return result;
+        }
+
+        /**
+         * Decrypts bytes [offset, offset + length) of ciphertext without
+         * touching the bytes before them (Vigenère's key phase at byte N
+         * is N mod the key length). The range is clipped to the input.
+         * @throws std::logic_error if the cipher changes the length, so
+         *         ciphertext and plaintext positions differ (A1Z26)
+         */
+        [[nodiscard]] std::string decryptRange(const std::string_view ciphertext, const std::size_t offset, const std::size_t length) const{
+            if (not preservesLength()) {
+                throw std::logic_error("decryptRange: cipher does not preserve length");
+            }
+            return decrypt(ciphertext.substr(std::min(offset, ciphertext.size()), length), offset);
+        }
+
+        /**
+         * Transforms message into a buffer owned by the calling thread and
+         * reused by its next call, so repeated calls stop allocating once
+         * the buffer has grown to fit
+         * @param message Must not point into a previous applyScratch() result
+         * @return View valid until this thread's next applyScratch() call
+         *         on any cipher
+         */
+        [[nodiscard]] std::string_view applyScratch(const std::string_view message, const Direction d, const std::size_t offset = 0) const{
+            thread_local std::string scratch;
+            stats::TransformTimer timer(*this, message.size());
+            const std::size_t size = transformedSize(message, d, offset);
+            if (scratch.size() < size) {
+                if (size > scratch.capacity()) {
+                    timer.allocated();
+                }
+                scratch.resize(size);
+            }
+            timer.produced(transformSpan(message, {scratch.data(), size}, d, offset));
+            return {scratch.data(), size};
+        }
+
+        /**
+         * Selects the instruction set used by vectorized kernels. Unsupported
+         * levels fall back to scalar; output is the same on every level.
+         */
+        void setSimdLevel(const SimdLevel level) noexcept{
+            simd_level = simdLevelSupported(level) ? level : SimdLevel::scalar;
+        }
+        [[nodiscard]] SimdLevel getSimdLevel() const noexcept{
+            return simd_level;
+        }
 
+        /**
+         * Transforms in into out.
+         * Const and allocation-free, so one configured cipher can serve
+         * any number of callers concurrently.
+         * @param in Source bytes
+         * @param out Destination, at least transformedSize(in) long; may
+         *            alias in for length-preserving ciphers
+         * @param d Encrypt or decrypt
+         * @param offset Position of in[0] within the overall stream
+         * @return Number of bytes written to out
+         * @throws std::length_error if out is too small
+         */
+        std::size_t transform(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset = 0) const{
+            if (out.size() < maxTransformedSize(in.size(), d) and out.size() < transformedSize(in, d, offset)) {
+                throw std::length_error("transform: output buffer too small");
+            }
+            stats::TransformTimer timer(*this, in.size());
+            const std::size_t written = transformSpan(in, out, d, offset);
+            timer.produced(written);
+            return written;
+        }
+
+        /**
+         * Transforms buffer where it lies
+         * @throws std::logic_error if the cipher changes the length
+         */
+        void transformInPlace(const std::span<char> buffer, const Direction d, const std::size_t offset = 0) const{
+            if (not preservesLength()) {
+                throw std::logic_error("transformInPlace: cipher does not preserve length");
+            }
+            stats::TransformTimer timer(*this, buffer.size());
+            transformSpan(buffer, buffer, d, offset);
+            timer.produced(buffer.size());
+        }
+
+        /**
+         * Short lowercase identifier, used to label statistics
+         */
+        [[nodiscard]] virtual std::string_view name() const noexcept{
+            return "custom";
+        }
+
+        /**
+         * Whether every input byte maps to exactly one output byte
+         */
+        [[nodiscard]] virtual bool preservesLength() const noexcept{
+            return true;
+        }
+
+        /**
+         * Whether a byte's output ignores where it sits in the stream;
+         * false for Vigenère, whose key phase follows the offset
+         */
+        [[nodiscard]] virtual bool positionIndependent() const noexcept{
+            return true;
+        }
+
+        /**
+         * Upper bound on the output size for n input bytes
+         */
+        [[nodiscard]] virtual std::size_t maxTransformedSize(const std::size_t n, const Direction d) const noexcept{
+            (void)d;
+            return n;
+        }
+
+        /**
+         * Exact output size for in; scans the input only for ciphers whose
+         * output length depends on the content
+         * @param offset Position of in[0] within the overall stream; only
+         *               pipelines whose length-changing stage follows a
+         *               position-dependent one depend on it
+         */
+        [[nodiscard]] virtual std::size_t transformedSize(const std::span<const char> in, const Direction d, const std::size_t offset = 0) const noexcept{
+            (void)offset;
+            return maxTransformedSize(in.size(), d);
+        }
+
+        /**
+         * Length of the longest prefix of input that can be transformed
+         * without looking at the bytes that follow it. Streaming drivers
+         * hold the remainder back and prepend it to the next chunk.
+         * @param input Chunk that is not the end of the stream
+         * @param d Direction the chunk will be transformed in
+         * @return Number of leading bytes safe to transform now
+         */
+        [[nodiscard]] virtual std::size_t completeLength(const std::string_view input, const Direction d) const noexcept{
+            (void)d;
+            return input.size();
+        }
+
+        /**
+         * First position at or after hint where in can be cut into two
+         * pieces that transform independently (given the right offset).
+         * Used by the parallel drivers to place chunk boundaries.
+         * @return A position in [hint, in.size()]
+         */
+        [[nodiscard]] virtual std::size_t splitPoint(const std::span<const char> in, const std::size_t hint, const Direction d) const noexcept{
+            (void)d;
+            return std::min(hint, in.size());
+        }
+
+    protected:
+        /**
+         * Cipher-specific kernel behind transform(). out is large enough
+         * and, for length-preserving ciphers, may be the same memory as in.
+         * The final ciphers override it as public, so callers holding the
+         * concrete type (see StaticCipher.hpp) reach it without a virtual
+         * call.
+         */
+        virtual std::size_t transformSpan(std::span<const char> in, std::span<char> out, Direction d, std::size_t offset) const noexcept = 0;
+
+};
@@ -0,0 +1,675 @@
+/**
+ * @file Equivalence.hpp
+ * @brief Differential Checks of the Optimized Engines Against Naive Code
+ *
+ * Every fast path has to produce exactly the bytes of the plain
+ * per-character ciphers, or it cannot be turned on. An EquivalenceCase is a cipher (or
+ * chain), a direction, a stream offset and an input. checkCase() runs it
+ * through every engine that applies and compares each result with the
+ * naive reference (namespace reference): the per-character loops the
+ * ciphers started from, with no tables, key streams, word skipping or
+ * vector kernels, applied stage after stage to the whole input.
+ *
+ * Engines checked:
+ * - level/<simd>: transform() on every SIMD level the CPU supports,
+ *   scalar included (tables, key streams, letter-free word skipping)
+ * - stream: IncrementalTransform fed random fragment sizes
+ * - parallel: parallelTransform() with a random chunk size
+ * - in-place, range: transformInPlace(), and a sub-range at its own
+ *   offset (decryptRange() when the case starts at offset 0)
+ * - batch: transformBatch() over records cut at random
+ * - variant, static: CipherVariant and CipherEngine<Fixed...>
+ * - small, small/message: SmallCipher on spans and SmallMessage
+ * - offload: OffloadCipher with no size threshold (OpenCL device only)
+ *
+ * Cases come from a seeded generator (randomCase(), for property runs)
+ * or from raw bytes (caseFromBytes(), for libFuzzer), so every failure
+ * can be replayed. throughputGate() times each fast path against the
+ * engine it replaces (and the scalar engine against the naive
+ * reference), so a regression that makes one slower fails too.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Batch.hpp"
+#include "CipherFactory.hpp"
+#include "CipherPipeline.hpp"
+#include "Offload.hpp"
+#include "Parallel.hpp"
+#include "SmallMessage.hpp"
+#include "StaticCipher.hpp"
+#include "Stream.hpp"
+#include "ThreadPool.hpp"
+#include<algorithm>
+#include<array>
+#include<charconv>
+#include<chrono>
+#include<cstddef>
+#include<cstdint>
+#include<limits>
+#include<memory>
+#include<random>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<utility>
+#include<vector>
+
+
+struct CipherStage {
+    CipherId id = CipherId::caesar;
+    std::string key;   // as for makeCipher()
+};
+
+struct EquivalenceCase {
+    std::vector<CipherStage> stages;   // more than one runs as a CipherPipeline
+    Direction direction = Direction::encrypt;
+    std::size_t offset = 0;            // stream position of input[0]
+    std::string input;
+    std::uint64_t split_seed = 0;      // fragment, chunk, range and record cuts
+};
+
+struct Mismatch {
+    std::string engine;
+    std::size_t position = 0;   // first differing output byte
+};
+
+/**
+ * One-line description of c, enough to rebuild it
+ */
+[[nodiscard]] inline std::string describeCase(const EquivalenceCase& c) {
+    std::string text;
+    for (const CipherStage& stage : c.stages) {
+        if (not text.empty()) {
+            text += ',';
+        }
+        switch (stage.id) {
+            case CipherId::caesar: text += "caesar"; break;
+            case CipherId::vigenere: text += "vigenere"; break;
+            case CipherId::a1z26: text += "a1z26"; break;
+            case CipherId::atbash: text += "atbash"; break;
+        }
+        if (needsKey(stage.id)) {
+            text += ':' + stage.key;
+        }
+    }
+    text += c.direction == Direction::encrypt ? " encrypt" : " decrypt";
+    text += " offset " + std::to_string(c.offset) + ", " + std::to_string(c.input.size()) + " bytes, split seed " + std::to_string(c.split_seed);
+    return text;
+}
+
+/**
+ * Naive reference ciphers: the per-character loops of the original Caesar,
+ * Vigenère, A1Z26 and Atbash, before any table, key stream, SIMD kernel or
+ * word skip, with the mod 26 wrap fixed (Caesar and Vigenère encryption
+ * overflowed past Z; Vigenère decryption now takes the same A=1 .. Z=26,
+ * non-letter 0 shift as encryption). Letters are ASCII. Deliberately
+ * slow, and shares no code with the engines, so a bug in any of them
+ * shows up as a mismatch.
+ */
+namespace reference {
+
+[[nodiscard]] constexpr bool isUpper(const char c) noexcept{
+    return c >= 'A' and c <= 'Z';
+}
+
+[[nodiscard]] constexpr bool isLower(const char c) noexcept{
+    return c >= 'a' and c <= 'z';
+}
+
+[[nodiscard]] constexpr bool isDigit(const char c) noexcept{
+    return c >= '0' and c <= '9';
+}
+
+[[nodiscard]] inline std::string caesar(const std::string_view message, int key, const Direction d) {
+    key = ((key % 26) + 26) % 26;
+    std::string result;
+    result.reserve(message.size());
+    for (const char c : message) {
+        if (isUpper(c)) {
+            result += static_cast<char>(d == Direction::encrypt ? (c - 'A' + key) % 26 + 'A' : (c - 'A' - key + 26) % 26 + 'A');
+        }
+        else if (isLower(c)) {
+            result += static_cast<char>(d == Direction::encrypt ? (c - 'a' + key) % 26 + 'a' : (c - 'a' - key + 26) % 26 + 'a');
+        }
+        else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+/**
+ * A=1, B=2, ..., Z=26 (so Z wraps to no shift), non-letters 0
+ */
+[[nodiscard]] constexpr int keyShift(const char c) noexcept{
+    if (isUpper(c)) {
+        return (c - 65 + 1) % 26;
+    }
+    if (isLower(c)) {
+        return (c - 97 + 1) % 26;
+    }
+    return 0;
+}
+
+/**
+ * @param offset Stream position of message[0]; the key advances on every
+ *               byte, letter or not
+ */
+[[nodiscard]] inline std::string vigenere(const std::string_view message, const std::string_view key, const Direction d, const std::size_t offset) {
+    std::string result;
+    result.reserve(message.size());
+    for (std::size_t i = 0; i < message.size(); ++i) {
+        const char c = message[i];
+        const int shift = keyShift(key[(offset + i) % key.size()]);
+        if (isUpper(c)) {
+            result += static_cast<char>(d == Direction::encrypt ? (c - 'A' + shift) % 26 + 'A' : (c - 'A' - shift + 26) % 26 + 'A');
+        }
+        else if (isLower(c)) {
+            result += static_cast<char>(d == Direction::encrypt ? (c - 'a' + shift) % 26 + 'a' : (c - 'a' - shift + 26) % 26 + 'a');
+        }
+        else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+[[nodiscard]] inline std::string atbash(const std::string_view message) {
+    std::string result;
+    result.reserve(message.size());
+    for (const char c : message) {
+        if (isUpper(c)) {
+            result += static_cast<char>(90 - (c - 65));
+        }
+        else if (isLower(c)) {
+            result += static_cast<char>(122 - (c - 97));
+        }
+        else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+[[nodiscard]] inline std::string a1z26(const std::string_view message, const Direction d) {
+    const auto position = [](const char c) {
+        return (isUpper(c) ? c - 'A' : c - 'a') + 1;
+    };
+    std::string result;
+    if (d == Direction::encrypt) {
+        for (const char c : message) {
+            if (isUpper(c) or isLower(c)) {
+                const int p = position(c);
+                result += p < 10 ? '0' + std::to_string(p) : std::to_string(p);
+            }
+            else if (isDigit(c)) {
+                result += static_cast<char>(c + 48);
+            }
+            else {
+                result += c;
+            }
+        }
+        return result;
+    }
+    for (std::size_t i = 0; i < message.size(); ++i) {
+        if (isDigit(message[i])) {
+            // A digit and whatever follows it form one group; std::stoi
+            // reads the second character only if it is a digit
+            const std::string num_str(message.substr(i++, 2));
+            const int num = std::stoi(num_str);
+            result += static_cast<char>('a' + num - 1);
+        }
+        else if (isUpper(message[i]) or isLower(message[i])) {
+            result += std::to_string(position(message[i]));
+        }
+        else {
+            result += message[i];
+        }
+    }
+    return result;
+}
+
+/**
+ * One stage, keyed as for makeCipher()
+ * @throws std::invalid_argument if the key is invalid
+ */
+[[nodiscard]] inline std::string transform(const CipherStage& stage, const Direction d, const std::string_view in, const std::size_t offset) {
+    switch (stage.id) {
+        case CipherId::caesar: {
+            int key = 0;
+            const char* const last = stage.key.data() + stage.key.size();
+            const auto [ptr, ec] = std::from_chars(stage.key.data(), last, key);
+            if (stage.key.empty() or ec != std::errc{} or ptr != last) {
+                throw std::invalid_argument("reference: invalid Caesar key \"" + stage.key + "\"");
+            }
+            return caesar(in, key, d);
+        }
+        case CipherId::vigenere:
+            if (stage.key.empty()) {
+                throw std::invalid_argument("reference: empty Vigenère key");
+            }
+            return vigenere(in, stage.key, d, offset);
+        case CipherId::a1z26:
+            return a1z26(in, d);
+        case CipherId::atbash:
+            return atbash(in);
+    }
+    return std::string(in);
+}
+
+/**
+ * Stages applied in turn (in reverse to decrypt); the stream offset
+ * reaches the stages up to the first length-changing one, later ones
+ * start from 0 (as in CipherPipeline)
+ */
+[[nodiscard]] inline std::string transform(const std::span<const CipherStage> stages, const Direction d, const std::string_view in, std::size_t offset) {
+    std::string current(in);
+    for (std::size_t k = 0; k < stages.size(); ++k) {
+        const CipherStage& stage = stages[d == Direction::encrypt ? k : stages.size() - 1 - k];
+        current = transform(stage, d, current, offset);
+        if (stage.id == CipherId::a1z26) {
+            offset = 0;
+        }
+    }
+    return current;
+}
+
+} // namespace reference
+
+namespace detail {
+
+/**
+ * Threads for the parallel engine; fixed, so chunks are split even on a
+ * single-core machine
+ */
+inline ThreadPool& equivalencePool() {
+    static ThreadPool pool(3);
+    return pool;
+}
+
+[[nodiscard]] inline std::shared_ptr<Encryption> makeStage(const CipherStage& stage, const SimdLevel level) {
+    std::shared_ptr<Encryption> cipher = makeCipher(stage.id, stage.key);
+    if (not cipher) {
+        throw std::invalid_argument("EquivalenceCase: invalid key \"" + stage.key + "\"");
+    }
+    cipher->setSimdLevel(level);
+    return cipher;
+}
+
+/**
+ * The case's cipher as an application would build it: one cipher, or a
+ * pipeline (which fuses what it can)
+ */
+[[nodiscard]] inline std::shared_ptr<const Encryption> buildCipher(const EquivalenceCase& c, const SimdLevel level) {
+    if (c.stages.empty()) {
+        throw std::invalid_argument("EquivalenceCase: no stages");
+    }
+    if (c.stages.size() == 1) {
+        return makeStage(c.stages.front(), level);
+    }
+    auto pipeline = std::make_shared<CipherPipeline>();
+    for (const CipherStage& stage : c.stages) {
+        pipeline->add(makeStage(stage, level));
+    }
+    return pipeline;
+}
+
+[[nodiscard]] inline std::string transformWhole(const Encryption& cipher, const std::string_view in, const Direction d, const std::size_t offset) {
+    std::string out(cipher.transformedSize(in, d, offset), '\0');
+    out.resize(cipher.transform(in, out, d, offset));
+    return out;
+}
+
+[[nodiscard]] inline std::size_t firstDifference(const std::string_view a, const std::string_view b) noexcept{
+    const auto [x, y] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+    return static_cast<std::size_t>(x - a.begin());
+}
+
+/**
+ * Random cut lengths for a case: mostly one granularity, with empty and
+ * single-byte pieces mixed in
+ */
+[[nodiscard]] inline std::size_t cutLength(std::mt19937_64& rng, const std::size_t granularity) {
+    switch (rng() % 8) {
+        case 0: return 0;
+        case 1: return 1;
+        default: return 1 + rng() % granularity;
+    }
+}
+
+template<std::size_t... K>
+void fixedCaesarTransform(const int key, const std::span<const char> in, const std::span<char> out, const Direction d, std::index_sequence<K...>) noexcept{
+    ((key == static_cast<int>(K) ? CipherEngine<FixedCaesar<static_cast<int>(K)>>::transform(in, out, d) : void()), ...);
+}
+
+} // namespace detail
+
+/**
+ * Runs c through every applicable engine
+ * @return One entry per engine whose output differs from the naive
+ *         reference;
+ *         empty when all agree
+ * @throws std::invalid_argument if c has no stages or an invalid key
+ */
+[[nodiscard]] inline std::vector<Mismatch> checkCase(const EquivalenceCase& c) {
+    std::vector<Mismatch> mismatches;
+    const auto compare = [&](std::string engine, const std::string_view actual, const std::string_view expected) {
+        if (actual != expected) {
+            mismatches.push_back({std::move(engine), detail::firstDifference(actual, expected)});
+        }
+    };
+
+    const Direction d = c.direction;
+    const std::string_view input = c.input;
+    const std::string expected = reference::transform(c.stages, d, input, c.offset);
+
+    for (const SimdLevel level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2, SimdLevel::neon}) {
+        if (simdLevelSupported(level)) {
+            compare("level/" + std::string(simdLevelName(level)), detail::transformWhole(*detail::buildCipher(c, level), input, d, c.offset), expected);
+        }
+    }
+
+    const std::shared_ptr<const Encryption> cipher = detail::buildCipher(c, bestSimdLevel());
+    std::mt19937_64 rng(c.split_seed);
+    const std::size_t granularity = std::array<std::size_t, 5>{1, 7, 64, 1000, 70000}[rng() % 5];
+
+    {
+        IncrementalTransform stream(*cipher, d, c.offset);
+        std::string out;
+        for (std::size_t position = 0; position < input.size(); ) {
+            const std::size_t length = std::min(detail::cutLength(rng, granularity), input.size() - position);
+            out += stream.update(input.substr(position, length));
+            position += length;
+        }
+        out += stream.finalize();
+        compare("stream", out, expected);
+    }
+
+    {
+        std::string out(cipher->transformedSize(input, d, c.offset), '\0');
+        out.resize(parallelTransform(*cipher, input, out, d, c.offset, detail::equivalencePool(), 1 + rng() % 4096));
+        compare("parallel", out, expected);
+    }
+
+    if (cipher->preservesLength()) {
+        std::string buffer(input);
+        cipher->transformInPlace(buffer, d, c.offset);
+        compare("in-place", buffer, expected);
+
+        const std::size_t begin = rng() % (input.size() + 1);
+        const std::size_t length = rng() % (input.size() - begin + 1);
+        const std::string range = d == Direction::decrypt and c.offset == 0
+            ? cipher->decryptRange(input, begin, length)
+            : detail::transformWhole(*cipher, input.substr(begin, length), d, c.offset + begin);
+        compare("range", range, std::string_view(expected).substr(begin, length));
+    }
+
+    {
+        // Records are independent messages, each from stream position 0
+        RecordBatch records;
+        RecordBatch results;
+        std::vector<std::string> wanted;
+        for (std::size_t position = 0; position < input.size(); ) {
+            const std::size_t length = std::min(detail::cutLength(rng, std::min<std::size_t>(granularity, 512)), input.size() - position);
+            records.add(input.substr(position, length));
+            wanted.push_back(reference::transform(c.stages, d, input.substr(position, length), 0));
+            position += length;
+        }
+        transformBatch(*cipher, records, results, d);
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < wanted.size(); ++i) {
+            if (results.size() != wanted.size() or results[i] != wanted[i]) {
+                mismatches.push_back({"batch", position + (results.size() == wanted.size() ? detail::firstDifference(results[i], wanted[i]) : 0)});
+                break;
+            }
+            position += wanted[i].size();
+        }
+    }
+
+    if (c.stages.size() == 1) {
+        const std::optional<CipherVariant> variant = makeCipherVariant(c.stages.front().id, c.stages.front().key);
+        std::string out(cipher->transformedSize(input, d, c.offset), '\0');
+        out.resize(visitTransform(*variant, input, out, d, c.offset));
+        compare("variant", out, expected);
+
+        if (const auto* const caesar = dynamic_cast<const Caesar*>(cipher.get())) {
+            std::string fixed(input.size(), '\0');
+            detail::fixedCaesarTransform(caesar->getKey(), input, fixed, d, std::make_index_sequence<26>{});
+            compare("static", fixed, expected);
+        }
+        else if (dynamic_cast<const Atbash*>(cipher.get()) != nullptr) {
+            std::string fixed(input.size(), '\0');
+            CipherEngine<FixedAtbash>::transform(input, fixed, d);
+            compare("static", fixed, expected);
+        }
+    }
+
+    if (const std::optional<SmallCipher> small = SmallCipher::of(*cipher)) {
+        std::string out(input.size(), '\0');
+        small->transform(input, out, d, c.offset);
+        compare("small", out, expected);
+        if (input.size() <= SMALL_MESSAGE_MAX) {
+            const SmallMessage<SMALL_MESSAGE_MAX> message(input);
+            const SmallMessage<SMALL_MESSAGE_MAX> result = d == Direction::encrypt ? small->encrypt(message, c.offset) : small->decrypt(message, c.offset);
+            compare("small/message", result.view(), expected);
+        }
+    }
+
+    if (OffloadCipher::supports(*cipher) and offloadDeviceName()) {
+        const OffloadCipher device(cipher, 0);
+        compare("offload", detail::transformWhole(device, input, d, c.offset), expected);
+    }
+    return mismatches;
+}
+
+/**
+ * Random case: usually one cipher, sometimes a chain of up to four;
+ * inputs mostly short, now and then long enough for every vector width
+ * and many parallel chunks, over letters, digits (A1Z26 pairs),
+ * punctuation, UTF-8 and arbitrary bytes
+ */
+[[nodiscard]] inline EquivalenceCase randomCase(std::mt19937_64& rng) {
+    constexpr std::string_view TEXT = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789  .,;!?-'\n\xc3\xa9\xe2\x82\xac";
+    EquivalenceCase c;
+    const std::size_t stages = rng() % 4 == 0 ? 2 + rng() % 3 : 1;
+    for (std::size_t i = 0; i < stages; ++i) {
+        CipherStage stage{static_cast<CipherId>(rng() % 4), {}};
+        if (stage.id == CipherId::caesar) {
+            stage.key = std::to_string(static_cast<int>(rng() % 121) - 60);
+        }
+        else if (stage.id == CipherId::vigenere) {
+            for (std::size_t k = 0, n = 1 + rng() % 16; k < n; ++k) {
+                stage.key += TEXT[rng() % (rng() % 8 == 0 ? TEXT.size() : 52)];
+            }
+        }
+        c.stages.push_back(std::move(stage));
+    }
+    c.direction = rng() % 2 == 0 ? Direction::encrypt : Direction::decrypt;
+    c.offset = rng() % 2 == 0 ? 0 : rng() % 1000000;
+
+    const std::size_t scale = rng() % 10;
+    const std::size_t length = scale < 6 ? rng() % 65 : scale < 9 ? rng() % 4097 : rng() % 300000;
+    // Digit-heavy input exercises the A1Z26 decoder
+    const std::size_t alphabet = rng() % 3 == 0 ? 10 : TEXT.size();
+    const std::size_t first = alphabet == 10 ? 52 : 0;
+    c.input.resize(length);
+    for (char& ch : c.input) {
+        ch = rng() % 16 == 0 ? static_cast<char>(rng()) : TEXT[first + rng() % alphabet];
+    }
+    c.split_seed = rng();
+    return c;
+}
+
+/**
+ * Case decoded from arbitrary bytes (libFuzzer input): a header picks the
+ * stages, keys, direction, offset and cuts; the rest is the message.
+ * Every byte string decodes to a valid case.
+ */
+[[nodiscard]] inline EquivalenceCase caseFromBytes(std::span<const unsigned char> data) {
+    const auto next = [&]() -> unsigned {
+        if (data.empty()) {
+            return 0;
+        }
+        const unsigned b = data.front();
+        data = data.subspan(1);
+        return b;
+    };
+    EquivalenceCase c;
+    const unsigned header = next();
+    c.direction = (header & 0x80) != 0 ? Direction::decrypt : Direction::encrypt;
+    for (unsigned i = 0, n = 1 + header % 4; i < n; ++i) {
+        CipherStage stage{static_cast<CipherId>(next() % 4), {}};
+        if (stage.id == CipherId::caesar) {
+            stage.key = std::to_string(static_cast<int>(next()) - 128);
+        }
+        else if (stage.id == CipherId::vigenere) {
+            for (unsigned k = 0, length = 1 + next() % 16; k < length; ++k) {
+                stage.key += static_cast<char>(next() | 1);   // never NUL, so the keyword keeps its length
+            }
+        }
+        c.stages.push_back(std::move(stage));
+    }
+    for (unsigned shift = 0; shift < 24; shift += 8) {
+        c.offset |= std::size_t{next()} << shift;
+    }
+    c.split_seed = next();
+    c.input.assign(reinterpret_cast<const char*>(data.data()), data.size());
+    return c;
+}
+
+/**
+ * Default input size for throughputGate(): well past the caches' reach
+ * of every per-call cost, small enough to finish in about a second
+ */
+inline constexpr std::size_t GATE_BYTES = std::size_t{1} << 22;
+
+struct GateResult {
+    std::string name;                 // <cipher>/<dir>/<level>, pipeline/fused, ...
+    double baseline_seconds = 0.0;    // best run of the path being replaced
+    double engine_seconds = 0.0;      // best run of the fast path
+
+    [[nodiscard]] double speedup() const noexcept{
+        return engine_seconds > 0.0 ? baseline_seconds / engine_seconds : 0.0;
+    }
+};
+
+namespace detail {
+
+template<typename F>
+[[nodiscard]] double bestSeconds(const unsigned repetitions, F&& f) {
+    double best = std::numeric_limits<double>::infinity();
+    for (unsigned r = 0; r < std::max(repetitions, 1u); ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+/**
+ * English-like text with punctuation and the odd digit
+ */
+[[nodiscard]] inline std::string gateSample(const std::size_t bytes) {
+    constexpr std::string_view WORDS[] = {"the ", "Quick ", "brown ", "fox, ", "jumps ", "over ", "a ", "lazy ", "dog. ", "In ", "1999 ", "it ", "said: ", "\"Hello!\" "};
+    std::mt19937_64 rng(1);
+    std::string text;
+    text.reserve(bytes + 16);
+    while (text.size() < bytes) {
+        text += WORDS[rng() % std::size(WORDS)];
+    }
+    text.resize(bytes);
+    return text;
+}
+
+} // namespace detail
+
+/**
+ * Times each fast path against the path it replaces:
+ * - <cipher>/<dir>/scalar: transform() at SimdLevel::scalar (tables, key
+ *   streams, word skipping) against the naive reference
+ * - <cipher>/<dir>/<level>: the best SIMD level against scalar
+ * - <cipher>/parallel: parallelTransform() against one thread at the
+ *   best level (only with more than one hardware thread)
+ * - small/<cipher>: SmallCipher on 16-byte tokens against transform()
+ *   into a caller-owned span
+ * - pipeline/fused: atbash,caesar:3,vigenere:SECRET as one CipherPipeline
+ *   against the three stages at the best level in turn
+ * @param bytes Input size per measurement
+ * @param repetitions Runs per side; the best run counts
+ */
+[[nodiscard]] inline std::vector<GateResult> throughputGate(const std::size_t bytes = GATE_BYTES, const unsigned repetitions = 5) {
+    std::vector<GateResult> results;
+    const std::string text = detail::gateSample(bytes);
+    const SimdLevel best = bestSimdLevel();
+    const std::pair<CipherId, std::string_view> specs[] = {
+        {CipherId::caesar, "3"}, {CipherId::vigenere, "SECRET"}, {CipherId::atbash, ""}, {CipherId::a1z26, ""},
+    };
+    volatile unsigned char sink = 0;
+
+    for (const auto& [id, key] : specs) {
+        const CipherStage stage{id, std::string(key)};
+        const std::shared_ptr<Encryption> scalar = detail::makeStage(stage, SimdLevel::scalar);
+        const std::shared_ptr<Encryption> fast = detail::makeStage(stage, best);
+        for (const Direction d : {Direction::encrypt, Direction::decrypt}) {
+            const std::string input = d == Direction::encrypt ? text : reference::transform(stage, Direction::encrypt, text, 0);
+            std::string out(scalar->maxTransformedSize(input.size(), d), '\0');
+            const std::string prefix = std::string(scalar->name()) + (d == Direction::encrypt ? "/encrypt" : "/decrypt");
+            const double naive = detail::bestSeconds(repetitions, [&] {
+                sink = static_cast<unsigned char>(reference::transform(stage, d, input, 0).back());
+            });
+            const double scalar_seconds = detail::bestSeconds(repetitions, [&] { scalar->transform(input, out, d); });
+            results.push_back({prefix + "/scalar", naive, scalar_seconds});
+            const double fast_seconds = best == SimdLevel::scalar ? scalar_seconds
+                : detail::bestSeconds(repetitions, [&] { fast->transform(input, out, d); });
+            if (best != SimdLevel::scalar) {
+                results.push_back({prefix + "/" + std::string(simdLevelName(best)), scalar_seconds, fast_seconds});
+            }
+            if (hardwareThreads() > 1 and d == Direction::encrypt) {
+                results.push_back({std::string(scalar->name()) + "/parallel", fast_seconds,
+                    detail::bestSeconds(repetitions, [&] { (void)parallelTransform(*fast, input, out, d); })});
+            }
+        }
+
+        if (const std::optional<SmallCipher> small = SmallCipher::of(*fast)) {
+            constexpr std::size_t TOKEN = 16;
+            std::string out(TOKEN, '\0');
+            std::vector<SmallMessage<TOKEN>> tokens;
+            for (std::size_t i = 0; i + TOKEN <= text.size(); i += TOKEN) {
+                tokens.emplace_back(std::string_view(text).substr(i, TOKEN));
+            }
+            results.push_back({"small/" + std::string(fast->name()),
+                detail::bestSeconds(repetitions, [&] {
+                    for (const SmallMessage<TOKEN>& token : tokens) {
+                        fast->transform(token.span(), out, Direction::encrypt);
+                        sink = static_cast<unsigned char>(out[0]);
+                    }
+                }),
+                detail::bestSeconds(repetitions, [&] {
+                    for (const SmallMessage<TOKEN>& token : tokens) {
+                        sink = static_cast<unsigned char>(small->encrypt(token).view()[0]);
+                    }
+                })});
+        }
+    }
+
+    const std::unique_ptr<CipherPipeline> pipeline = parsePipeline("atbash,caesar:3,vigenere:SECRET");
+    const std::vector<std::shared_ptr<Encryption>> stages = {
+        detail::makeStage({CipherId::atbash, ""}, best),
+        detail::makeStage({CipherId::caesar, "3"}, best),
+        detail::makeStage({CipherId::vigenere, "SECRET"}, best),
+    };
+    std::string out(text.size(), '\0');
+    results.push_back({"pipeline/fused",
+        detail::bestSeconds(repetitions, [&] {
+            stages[0]->transform(text, out, Direction::encrypt);
+            stages[1]->transformInPlace(out, Direction::encrypt);
+            stages[2]->transformInPlace(out, Direction::encrypt);
+        }),
+        detail::bestSeconds(repetitions, [&] { pipeline->transform(text, out, Direction::encrypt); })});
+    return results;
+}
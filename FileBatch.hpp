@@ -0,0 +1,349 @@
+/**
+ * @file FileBatch.hpp
+ * @brief Parallel Transform of a Directory Tree
+ *
+ * Encrypts or decrypts every regular file below one directory into a
+ * mirror tree, keeping all threads busy however uneven the file sizes
+ * are. Files are planned into tasks for a WorkStealingPool:
+ *
+ * - A file larger than the chunk size becomes one task that loads it and
+ *   then spawns a task per chunk, cut with splitPoint() exactly as
+ *   parallelTransform() cuts a buffer. Whoever finishes the last chunk
+ *   writes the file.
+ * - Smaller files are packed together, largest first, into tasks of
+ *   about one chunk's worth of bytes, so ten thousand tiny files cost a
+ *   few hundred tasks rather than ten thousand.
+ *
+ * Tasks are queued smallest first, so every thread starts on the biggest
+ * work it owns and idle threads steal what is left, chunks of big files
+ * included.
+ *
+ * Every file is a message of its own, starting at stream offset 0, so the
+ * output matches running the streaming CLI on each file separately. A
+ * file that cannot be read or written is recorded and skipped.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include "Stats.hpp"
+#include "WorkStealing.hpp"
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<cstddef>
+#include<filesystem>
+#include<fstream>
+#include<memory>
+#include<mutex>
+#include<optional>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<utility>
+#include<vector>
+
+
+/**
+ * One file of a batch and where its result goes
+ */
+struct BatchFile {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    std::size_t size = 0;
+};
+
+struct BatchSummary {
+    std::size_t files = 0;
+    std::size_t bytes_in = 0;
+    std::size_t bytes_out = 0;
+    std::size_t tasks = 0;
+    std::size_t steals = 0;
+    unsigned threads = 1;
+    double seconds = 0;
+    std::vector<std::string> errors;    // one message per failed file
+
+    /**
+     * Input bytes per second of wall time
+     */
+    [[nodiscard]] double throughput() const noexcept{
+        return seconds > 0 ? static_cast<double>(bytes_in) / seconds : 0;
+    }
+};
+
+/**
+ * Lists the regular files below input_dir and creates the matching
+ * directories below output_dir
+ * @return Files with their output paths, in directory order
+ * @throws std::invalid_argument if input_dir is not a directory or
+ *         output_dir lies inside it
+ * @throws std::filesystem::filesystem_error if a directory cannot be
+ *         walked or created
+ */
+[[nodiscard]] inline std::vector<BatchFile> listBatchFiles(const std::filesystem::path& input_dir, const std::filesystem::path& output_dir) {
+    namespace fs = std::filesystem;
+    if (not fs::is_directory(input_dir)) {
+        throw std::invalid_argument("'" + input_dir.string() + "' is not a directory");
+    }
+    // Writing into the tree being walked would pick up our own output
+    const fs::path root = fs::canonical(input_dir);
+    const fs::path target = fs::weakly_canonical(output_dir);
+    if (std::mismatch(root.begin(), root.end(), target.begin(), target.end()).first == root.end()) {
+        throw std::invalid_argument("output directory '" + output_dir.string() + "' lies inside the input directory");
+    }
+
+    std::vector<BatchFile> files;
+    fs::create_directories(output_dir);
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input_dir)) {
+        const fs::path relative = fs::relative(entry.path(), input_dir);
+        if (entry.is_directory()) {
+            fs::create_directories(output_dir / relative);
+        }
+        else if (entry.is_regular_file()) {
+            files.push_back({entry.path(), output_dir / relative, static_cast<std::size_t>(entry.file_size())});
+        }
+    }
+    return files;
+}
+
+namespace detail {
+
+/**
+ * Shared state of one batch run
+ */
+struct BatchRun {
+    const Encryption& cipher;
+    Direction direction;
+    std::size_t chunk_size;
+    WorkStealingPool& pool;
+    std::atomic<std::size_t> files{0};
+    std::atomic<std::size_t> bytes_in{0};
+    std::atomic<std::size_t> bytes_out{0};
+    std::atomic<std::size_t> tasks{0};
+    std::mutex errors_mutex;
+    std::vector<std::string> errors;
+
+    BatchRun(const Encryption& c, const Direction d, const std::size_t chunk, WorkStealingPool& p)
+        : cipher(c), direction(d), chunk_size(chunk), pool(p) {}
+
+    void fail(const BatchFile& file, const std::string& what) {
+        const std::lock_guard lock(errors_mutex);
+        errors.push_back(file.input.string() + ": " + what);
+    }
+
+    void done(const std::size_t in, const std::size_t out) noexcept{
+        files.fetch_add(1, std::memory_order_relaxed);
+        bytes_in.fetch_add(in, std::memory_order_relaxed);
+        bytes_out.fetch_add(out, std::memory_order_relaxed);
+    }
+};
+
+inline void readWhole(const std::filesystem::path& path, std::vector<char>& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (not in) {
+        throw std::runtime_error("cannot open for reading");
+    }
+    stats::IoTimer timer;
+    in.seekg(0, std::ios::end);
+    data.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (not in) {
+        throw std::runtime_error("read failed");
+    }
+    timer.record(stats::IoOp::read, data.size());
+}
+
+inline void writeWhole(const std::filesystem::path& path, const std::span<const std::vector<char>> pieces) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (not out) {
+        throw std::runtime_error("cannot open '" + path.string() + "' for writing");
+    }
+    stats::IoTimer timer;
+    std::size_t bytes = 0;
+    for (const std::vector<char>& piece : pieces) {
+        out.write(piece.data(), static_cast<std::streamsize>(piece.size()));
+        bytes += piece.size();
+    }
+    out.close();
+    if (not out) {
+        throw std::runtime_error("write to '" + path.string() + "' failed");
+    }
+    timer.record(stats::IoOp::write, bytes);
+}
+
+/**
+ * A file split into chunk tasks; the chunk that finishes last writes it.
+ * The input is mapped where the platform allows, and the results wait in
+ * memory until every chunk is done.
+ */
+struct LargeFile {
+    const BatchFile& file;
+    BatchRun& run;
+#if CIPHERSUITE_HAS_MMAP
+    std::optional<MappedFile> mapping;
+#endif
+    std::vector<char> data;
+    std::span<const char> in;
+    std::vector<std::size_t> bounds{0};
+    std::vector<std::vector<char>> pieces;
+    std::atomic<std::size_t> remaining{0};
+    std::atomic<bool> failed{false};
+
+    LargeFile(const BatchFile& f, BatchRun& r) : file(f), run(r) {}
+
+    void load() {
+#if CIPHERSUITE_HAS_MMAP
+        mapping.emplace(file.input.string(), MappedFile::Mode::read);
+        in = mapping->data();
+#else
+        readWhole(file.input, data);
+        in = data;
+#endif
+        while (bounds.back() < in.size()) {
+            bounds.push_back(run.cipher.splitPoint(in, bounds.back() + run.chunk_size, run.direction));
+        }
+        pieces.resize(bounds.size() - 1);
+        remaining.store(pieces.size());
+    }
+
+    void transformChunk(const std::size_t c) {
+        try {
+            const auto piece = in.subspan(bounds[c], bounds[c + 1] - bounds[c]);
+            pieces[c].resize(run.cipher.transformedSize(piece, run.direction, bounds[c]));
+            run.cipher.transform(piece, pieces[c], run.direction, bounds[c]);
+        }
+        catch (const std::exception& e) {
+            if (not failed.exchange(true)) {
+                run.fail(file, e.what());
+            }
+        }
+        if (remaining.fetch_sub(1) == 1 and not failed.load()) {
+            finish();
+        }
+    }
+
+    void finish() {
+        try {
+            writeWhole(file.output, pieces);
+            std::size_t out = 0;
+            for (const std::vector<char>& piece : pieces) {
+                out += piece.size();
+            }
+            run.done(in.size(), out);
+        }
+        catch (const std::exception& e) {
+            run.fail(file, e.what());
+        }
+    }
+};
+
+inline void transformLarge(BatchRun& run, const BatchFile& file) {
+    const auto large = std::make_shared<LargeFile>(file, run);
+    try {
+        large->load();
+    }
+    catch (const std::exception& e) {
+        run.fail(file, e.what());
+        return;
+    }
+    if (large->pieces.empty()) {
+        large->finish();
+        return;
+    }
+    run.tasks.fetch_add(large->pieces.size(), std::memory_order_relaxed);
+    for (std::size_t c = 1; c < large->pieces.size(); ++c) {
+        run.pool.spawn([large, c] { large->transformChunk(c); });
+    }
+    large->transformChunk(0);
+}
+
+inline void transformSmall(BatchRun& run, const std::span<const BatchFile* const> group) {
+    std::vector<char> data;
+    std::vector<char> result;
+    for (const BatchFile* const file : group) {
+        try {
+            readWhole(file->input, data);
+            result.resize(run.cipher.transformedSize(data, run.direction));
+            run.cipher.transform(data, result, run.direction);
+            writeWhole(file->output, std::span(&result, 1));
+            run.done(data.size(), result.size());
+        }
+        catch (const std::exception& e) {
+            run.fail(*file, e.what());
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * Transforms every listed file into its output path
+ * @param cipher Configured cipher; only const members are used
+ * @param files Inputs and outputs, e.g. from listBatchFiles(); the output
+ *              directories must exist
+ * @param d Encrypt or decrypt
+ * @param threads Threads to run on, the caller included
+ * @param chunk_size Files above this size are split into chunks of about
+ *                   this size; smaller ones are packed up to it
+ * @return Totals and per-file errors; never throws for a single file
+ */
+[[nodiscard]] inline BatchSummary transformFiles(const Encryption& cipher, const std::span<const BatchFile> files, const Direction d, const unsigned threads, const std::size_t chunk_size = PARALLEL_CHUNK_SIZE) {
+    const auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+    detail::BatchRun run(cipher, d, std::max<std::size_t>(chunk_size, 1), pool);
+
+    std::vector<const BatchFile*> order;
+    order.reserve(files.size());
+    for (const BatchFile& file : files) {
+        order.push_back(&file);
+    }
+    std::sort(order.begin(), order.end(), [](const BatchFile* a, const BatchFile* b) { return a->size > b->size; });
+
+    // Plan largest first, queue smallest first: each thread pops its
+    // newest task, so it starts on its largest
+    std::vector<WorkStealingPool::Task> plan;
+    std::size_t next = 0;
+    for (; next < order.size() and order[next]->size > run.chunk_size; ++next) {
+        plan.push_back([&run, file = order[next]] { detail::transformLarge(run, *file); });
+    }
+    const std::span<const BatchFile* const> small = std::span(order).subspan(next);
+    for (std::size_t first = 0; first < small.size();) {
+        std::size_t last = first;
+        for (std::size_t bytes = 0; last < small.size() and (last == first or bytes + small[last]->size <= run.chunk_size); ++last) {
+            bytes += small[last]->size;
+        }
+        plan.push_back([&run, group = small.subspan(first, last - first)] { detail::transformSmall(run, group); });
+        first = last;
+    }
+    run.tasks.fetch_add(plan.size(), std::memory_order_relaxed);
+    for (auto task = plan.rbegin(); task != plan.rend(); ++task) {
+        pool.spawn(std::move(*task));
+    }
+    pool.run();
+
+    BatchSummary summary;
+    summary.files = run.files.load();
+    summary.bytes_in = run.bytes_in.load();
+    summary.bytes_out = run.bytes_out.load();
+    summary.tasks = run.tasks.load();
+    summary.steals = pool.steals();
+    summary.threads = pool.concurrency();
+    summary.seconds = static_cast<double>(stats::nanosecondsSince(start)) / 1e9;
+    summary.errors = std::move(run.errors);
+    return summary;
+}
+
+/**
+ * Transforms the whole tree below input_dir into output_dir
+ * @throws As listBatchFiles(); per-file failures land in the summary
+ */
+[[nodiscard]] inline BatchSummary transformDirectory(const Encryption& cipher, const std::filesystem::path& input_dir, const std::filesystem::path& output_dir, const Direction d, const unsigned threads, const std::size_t chunk_size = PARALLEL_CHUNK_SIZE) {
+    const std::vector<BatchFile> files = listBatchFiles(input_dir, output_dir);
+    return transformFiles(cipher, files, d, threads, chunk_size);
+}
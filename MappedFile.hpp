@@ -0,0 +1,262 @@
+/**
+ * @file MappedFile.hpp
+ * @brief Memory-Mapped File Transform
+ *
+ * Zero-copy path for files on local disk. The input is mapped instead of
+ * read() into a buffer, and length-preserving ciphers (Caesar, Vigenère,
+ * Atbash) write either back into the same mapping or straight into a
+ * mapping of the output file. No user-space copy of the data is made.
+ *
+ * Features:
+ * - RAII MappedFile wrapper over mmap()/munmap()
+ * - madvise(MADV_SEQUENTIAL) on every mapping so the kernel reads ahead
+ * - Works window by window and drops finished windows with
+ *   MADV_DONTNEED, so resident memory stays bounded on multi-GB files
+ * - Optional ThreadPool to split each window across threads
+ *
+ * POSIX only; CIPHERSUITE_HAS_MMAP is 0 where <sys/mman.h> is missing.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include "Parallel.hpp"
+#include<algorithm>
+#include<cerrno>
+#include<cstddef>
+#include<filesystem>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<utility>
+
+#if __has_include(<sys/mman.h>)
+#define CIPHERSUITE_HAS_MMAP 1
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#else
+#define CIPHERSUITE_HAS_MMAP 0
+#endif
+
+
+/**
+ * Bytes transformed between MADV_DONTNEED calls
+ */
+inline constexpr std::size_t MAPPED_WINDOW_SIZE = std::size_t{1} << 23;
+
+#if CIPHERSUITE_HAS_MMAP
+
+/**
+ * Shared mapping of a whole file; writes to a writable mapping reach the
+ * file itself
+ */
+class MappedFile {
+    public:
+        enum class Mode { read, readWrite };
+
+        /**
+         * Maps an existing file
+         * @throws std::system_error if the file cannot be opened or mapped
+         */
+        MappedFile(const std::string& path, const Mode mode) {
+            fd = ::open(path.c_str(), mode == Mode::read ? O_RDONLY : O_RDWR);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "open '" + path + "'");
+            }
+            struct stat info {};
+            if (::fstat(fd, &info) != 0) {
+                fail("fstat '" + path + "'");
+            }
+            map(static_cast<std::size_t>(info.st_size), mode);
+        }
+
+        /**
+         * Creates (or truncates) path to size bytes and maps it writable
+         * @throws std::system_error if the file cannot be created or mapped
+         */
+        MappedFile(const std::string& path, const std::size_t size) {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "create '" + path + "'");
+            }
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                fail("ftruncate '" + path + "'");
+            }
+            map(size, Mode::readWrite);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : fd(std::exchange(other.fd, -1)), bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {}
+
+        MappedFile& operator=(MappedFile&& other) noexcept{
+            if (this != &other) {
+                unmap();
+                fd = std::exchange(other.fd, -1);
+                bytes = std::exchange(other.bytes, nullptr);
+                length = std::exchange(other.length, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+            unmap();
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept{
+            return length;
+        }
+
+        [[nodiscard]] std::span<char> data() const noexcept{
+            return {bytes, length};
+        }
+
+        /**
+         * Tells the kernel a range is no longer needed, releasing its pages
+         * from this process (dirty pages of a shared mapping stay in the
+         * page cache and are still written back)
+         */
+        void discard(const std::size_t offset, const std::size_t count) const noexcept{
+            const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            const std::size_t begin = offset / page * page;
+            if (bytes != nullptr and begin < length) {
+                ::madvise(bytes + begin, std::min(offset + count, length) - begin, MADV_DONTNEED);
+            }
+        }
+
+        /**
+         * Flushes a writable mapping to disk
+         * @throws std::system_error if msync() fails
+         */
+        void sync() const{
+            stats::IoTimer timer;
+            if (bytes != nullptr and ::msync(bytes, length, MS_SYNC) != 0) {
+                throw std::system_error(errno, std::generic_category(), "msync");
+            }
+            timer.record(stats::IoOp::write, length);
+        }
+
+    private:
+        int fd = -1;
+        char* bytes = nullptr;
+        std::size_t length = 0;
+
+        void map(const std::size_t size, const Mode mode) {
+            length = size;
+            // mmap() rejects empty ranges; an empty file maps to an empty span
+            if (size == 0) {
+                return;
+            }
+            const int protection = mode == Mode::read ? PROT_READ : PROT_READ | PROT_WRITE;
+            void* const address = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED) {
+                fail("mmap");
+            }
+            bytes = static_cast<char*>(address);
+            ::madvise(address, size, MADV_SEQUENTIAL);
+        }
+
+        [[noreturn]] void fail(const std::string& what) {
+            const int error = errno;
+            ::close(fd);
+            fd = -1;
+            throw std::system_error(error, std::generic_category(), what);
+        }
+
+        void unmap() noexcept{
+            if (bytes != nullptr) {
+                ::munmap(bytes, length);
+                bytes = nullptr;
+            }
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+};
+
+namespace detail {
+
+/**
+ * Runs the cipher over in -> out window by window, releasing each window
+ * once it is done
+ */
+inline void transformMapped(const Encryption& cipher, const MappedFile& in, const MappedFile& out, const Direction d, ThreadPool* const pool) {
+    const std::span<const char> source = in.data();
+    const std::span<char> target = out.data();
+    for (std::size_t offset = 0; offset < source.size(); offset += MAPPED_WINDOW_SIZE) {
+        const std::size_t count = std::min(MAPPED_WINDOW_SIZE, source.size() - offset);
+        const auto from = source.subspan(offset, count);
+        const auto to = target.subspan(offset, count);
+        if (pool != nullptr) {
+            parallelTransform(cipher, from, to, d, offset, *pool);
+        }
+        else {
+            cipher.transform(from, to, d, offset);
+        }
+        in.discard(offset, count);
+        if (&in != &out) {
+            out.discard(offset, count);
+        }
+    }
+}
+
+inline void requireLengthPreserving(const Encryption& cipher) {
+    if (not cipher.preservesLength()) {
+        throw std::logic_error("mapped transform: cipher does not preserve length");
+    }
+}
+
+} // namespace detail
+
+/**
+ * Rewrites a file in place through a writable mapping
+ * @param cipher Configured length-preserving cipher
+ * @param path File to rewrite
+ * @param d Encrypt or decrypt
+ * @param pool When set, each window is split across these threads
+ * @throws std::logic_error if the cipher changes the length
+ * @throws std::system_error on any file or mapping error
+ */
+inline void mappedTransformInPlace(const Encryption& cipher, const std::string& path, const Direction d, ThreadPool* const pool = nullptr) {
+    detail::requireLengthPreserving(cipher);
+    const MappedFile file(path, MappedFile::Mode::readWrite);
+    detail::transformMapped(cipher, file, file, d, pool);
+    file.sync();
+}
+
+/**
+ * Transforms input_path into a mapping of output_path (created or
+ * truncated to the input's size)
+ * @param cipher Configured length-preserving cipher
+ * @param input_path Source file, mapped read-only
+ * @param output_path Destination file; naming the input file itself
+ *                    rewrites it in place
+ * @param d Encrypt or decrypt
+ * @param pool When set, each window is split across these threads
+ * @throws std::logic_error if the cipher changes the length
+ * @throws std::system_error on any file or mapping error
+ */
+inline void mappedTransform(const Encryption& cipher, const std::string& input_path, const std::string& output_path, const Direction d, ThreadPool* const pool = nullptr) {
+    detail::requireLengthPreserving(cipher);
+    // Truncating the output would wipe an input that is the same file
+    std::error_code ec;
+    if (std::filesystem::equivalent(input_path, output_path, ec)) {
+        mappedTransformInPlace(cipher, input_path, d, pool);
+        return;
+    }
+    const MappedFile in(input_path, MappedFile::Mode::read);
+    const MappedFile out(output_path, in.size());
+    detail::transformMapped(cipher, in, out, d, pool);
+    out.sync();
+}
+
+#endif
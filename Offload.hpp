@@ -0,0 +1,567 @@
+/**
+ * @file Offload.hpp
+ * @brief OpenCL Offload of the Letter-Substitution Ciphers
+ *
+ * OffloadCipher runs Caesar, Atbash, Vigenère and chains of them (anything
+ * with a single AffineLetters pass, see CipherPipeline.hpp) on a GPU or other OpenCL
+ * accelerator, behind the ordinary Encryption interface, so every driver
+ * (streaming, mmap, batch) can use it unchanged.
+ *
+ * The OpenCL runtime is loaded with dlopen() when first needed, so
+ * building needs neither OpenCL headers nor an OpenCL library, and a
+ * machine without a device simply keeps using the CPU.
+ *
+ * Data moves in chunks through two slots, each with a pinned host buffer
+ * pair, a device buffer pair and its own in-order queue. While the device
+ * copies and transforms one chunk, the host stages the next chunk into the
+ * other slot and copies the previous result out, so PCIe transfers,
+ * kernels and host copies overlap.
+ *
+ * Falls back to the wrapped CPU cipher:
+ * - for inputs below the size threshold, where transfer latency would
+ *   cost more than the kernel saves
+ * - when no OpenCL device is present or the runtime reports an error
+ * - when another thread is using the device, so parallel drivers keep
+ *   every CPU core busy as well
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherPipeline.hpp"
+#include<algorithm>
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<mutex>
+#include<optional>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<type_traits>
+#include<vector>
+
+#if __has_include(<dlfcn.h>)
+#include<dlfcn.h>
+#define CIPHERSUITE_HAS_OPENCL 1
+#else
+#define CIPHERSUITE_HAS_OPENCL 0
+#endif
+
+
+/**
+ * Inputs below this size stay on the CPU
+ */
+inline constexpr std::size_t OFFLOAD_MIN_BYTES = std::size_t{1} << 23;
+
+/**
+ * Bytes per transfer slot; two slots are in flight at once
+ */
+inline constexpr std::size_t OFFLOAD_CHUNK_BYTES = std::size_t{1} << 22;
+
+#if CIPHERSUITE_HAS_OPENCL
+
+namespace opencl {
+
+// The subset of the OpenCL 1.2 C API used here; its ABI is fixed by the
+// Khronos headers, so no SDK is needed to call into an installed runtime
+using cl_int = std::int32_t;
+using cl_uint = std::uint32_t;
+using cl_bitfield = std::uint64_t;
+using cl_platform_id = struct _cl_platform_id*;
+using cl_device_id = struct _cl_device_id*;
+using cl_context = struct _cl_context*;
+using cl_command_queue = struct _cl_command_queue*;
+using cl_mem = struct _cl_mem*;
+using cl_program = struct _cl_program*;
+using cl_kernel = struct _cl_kernel*;
+using cl_event = struct _cl_event*;
+
+inline constexpr cl_int SUCCESS = 0;
+inline constexpr cl_uint TRUE = 1;
+inline constexpr cl_uint FALSE = 0;
+inline constexpr cl_bitfield DEVICE_TYPE_GPU = 1 << 2;
+inline constexpr cl_bitfield DEVICE_TYPE_ACCELERATOR = 1 << 3;
+inline constexpr cl_bitfield MEM_READ_WRITE = 1 << 0;
+inline constexpr cl_bitfield MEM_WRITE_ONLY = 1 << 1;
+inline constexpr cl_bitfield MEM_READ_ONLY = 1 << 2;
+inline constexpr cl_bitfield MEM_ALLOC_HOST_PTR = 1 << 4;
+inline constexpr cl_bitfield MAP_READ = 1 << 0;
+inline constexpr cl_bitfield MAP_WRITE = 1 << 1;
+inline constexpr cl_uint DEVICE_NAME = 0x102B;
+
+/**
+ * Entry points resolved from the installed runtime
+ */
+struct Api {
+    cl_int (*GetPlatformIDs)(cl_uint, cl_platform_id*, cl_uint*);
+    cl_int (*GetDeviceIDs)(cl_platform_id, cl_bitfield, cl_uint, cl_device_id*, cl_uint*);
+    cl_int (*GetDeviceInfo)(cl_device_id, cl_uint, std::size_t, void*, std::size_t*);
+    cl_context (*CreateContext)(const std::intptr_t*, cl_uint, const cl_device_id*, void (*)(const char*, const void*, std::size_t, void*), void*, cl_int*);
+    cl_command_queue (*CreateCommandQueue)(cl_context, cl_device_id, cl_bitfield, cl_int*);
+    cl_mem (*CreateBuffer)(cl_context, cl_bitfield, std::size_t, void*, cl_int*);
+    cl_program (*CreateProgramWithSource)(cl_context, cl_uint, const char**, const std::size_t*, cl_int*);
+    cl_int (*BuildProgram)(cl_program, cl_uint, const cl_device_id*, const char*, void (*)(cl_program, void*), void*);
+    cl_kernel (*CreateKernel)(cl_program, const char*, cl_int*);
+    cl_int (*SetKernelArg)(cl_kernel, cl_uint, std::size_t, const void*);
+    cl_int (*EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, std::size_t, std::size_t, const void*, cl_uint, const cl_event*, cl_event*);
+    cl_int (*EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, std::size_t, std::size_t, void*, cl_uint, const cl_event*, cl_event*);
+    cl_int (*EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const std::size_t*, const std::size_t*, const std::size_t*, cl_uint, const cl_event*, cl_event*);
+    void* (*EnqueueMapBuffer)(cl_command_queue, cl_mem, cl_uint, cl_bitfield, std::size_t, std::size_t, cl_uint, const cl_event*, cl_event*, cl_int*);
+    cl_int (*EnqueueUnmapMemObject)(cl_command_queue, cl_mem, void*, cl_uint, const cl_event*, cl_event*);
+    cl_int (*WaitForEvents)(cl_uint, const cl_event*);
+    cl_int (*Flush)(cl_command_queue);
+    cl_int (*Finish)(cl_command_queue);
+    cl_int (*ReleaseEvent)(cl_event);
+    cl_int (*ReleaseMemObject)(cl_mem);
+    cl_int (*ReleaseKernel)(cl_kernel);
+    cl_int (*ReleaseProgram)(cl_program);
+    cl_int (*ReleaseCommandQueue)(cl_command_queue);
+    cl_int (*ReleaseContext)(cl_context);
+
+    /**
+     * Loads the runtime and every entry point
+     * @return The table, or nullopt if OpenCL is not installed
+     */
+    [[nodiscard]] static std::optional<Api> load() noexcept{
+        void* library = ::dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            library = ::dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+        }
+        if (library == nullptr) {
+            return std::nullopt;
+        }
+        Api api{};
+        bool complete = true;
+        const auto resolve = [&](auto& fn, const char* const symbol) {
+            void* const address = ::dlsym(library, symbol);
+            complete = complete and address != nullptr;
+            fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(address);
+        };
+        resolve(api.GetPlatformIDs, "clGetPlatformIDs");
+        resolve(api.GetDeviceIDs, "clGetDeviceIDs");
+        resolve(api.GetDeviceInfo, "clGetDeviceInfo");
+        resolve(api.CreateContext, "clCreateContext");
+        resolve(api.CreateCommandQueue, "clCreateCommandQueue");
+        resolve(api.CreateBuffer, "clCreateBuffer");
+        resolve(api.CreateProgramWithSource, "clCreateProgramWithSource");
+        resolve(api.BuildProgram, "clBuildProgram");
+        resolve(api.CreateKernel, "clCreateKernel");
+        resolve(api.SetKernelArg, "clSetKernelArg");
+        resolve(api.EnqueueWriteBuffer, "clEnqueueWriteBuffer");
+        resolve(api.EnqueueReadBuffer, "clEnqueueReadBuffer");
+        resolve(api.EnqueueNDRangeKernel, "clEnqueueNDRangeKernel");
+        resolve(api.EnqueueMapBuffer, "clEnqueueMapBuffer");
+        resolve(api.EnqueueUnmapMemObject, "clEnqueueUnmapMemObject");
+        resolve(api.WaitForEvents, "clWaitForEvents");
+        resolve(api.Flush, "clFlush");
+        resolve(api.Finish, "clFinish");
+        resolve(api.ReleaseEvent, "clReleaseEvent");
+        resolve(api.ReleaseMemObject, "clReleaseMemObject");
+        resolve(api.ReleaseKernel, "clReleaseKernel");
+        resolve(api.ReleaseProgram, "clReleaseProgram");
+        resolve(api.ReleaseCommandQueue, "clReleaseCommandQueue");
+        resolve(api.ReleaseContext, "clReleaseContext");
+        if (not complete) {
+            ::dlclose(library);
+            return std::nullopt;
+        }
+        // The runtime stays loaded for the life of the process
+        return api;
+    }
+};
+
+/**
+ * x -> s * x + b[i mod p] on ASCII letters, one byte per work item
+ */
+inline constexpr std::string_view KERNEL_SOURCE = R"CL(
+__kernel void affineLetters(__global const uchar* in, __global uchar* out, __global const uchar* shifts,
+                            const uint period, const uint phase, const int reflect, const int decrypt, const uint n)
+{
+    const uint i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+    uchar c = in[i];
+    const uchar upper = c & 0xDF;
+    if (upper >= 'A' && upper <= 'Z') {
+        const int x = upper - 'A';
+        const int b = shifts[(phase + i) % period];
+        const int y = reflect ? (b - x + 26) % 26 : decrypt ? (x - b + 26) % 26 : (x + b) % 26;
+        c = (uchar)((c & 0x20) | ('A' + y));
+    }
+    out[i] = c;
+}
+)CL";
+
+} // namespace opencl
+
+/**
+ * First GPU (or other accelerator) of the first platform that has one,
+ * with the compiled kernel and two transfer slots
+ */
+class OffloadDevice {
+    public:
+        OffloadDevice(const OffloadDevice&) = delete;
+        OffloadDevice& operator=(const OffloadDevice&) = delete;
+
+        ~OffloadDevice() {
+            release();
+        }
+
+        /**
+         * Process-wide device, set up on first use
+         * @return nullptr if there is no usable OpenCL device
+         */
+        [[nodiscard]] static OffloadDevice* shared() {
+            static const std::unique_ptr<OffloadDevice> device = open();
+            return device.get();
+        }
+
+        [[nodiscard]] const std::string& name() const noexcept{
+            return device_name;
+        }
+
+        /**
+         * Transforms in into out (which may alias in) with the affine
+         * letter map (reflect, shifts) starting at stream position offset
+         * @return Length of the prefix of out that is finished, in.size()
+         *         unless the runtime failed; chunks land in order and none
+         *         past a failure, so the CPU can resume at that point
+         *         even when out aliases in
+         */
+        [[nodiscard]] std::size_t transform(const std::span<const char> in, const std::span<char> out, const bool reflect, const bool decrypt,
+            const std::span<const unsigned char> shifts, const std::size_t offset) {
+            std::unique_lock lock(mutex, std::try_to_lock);
+            if (not lock.owns_lock() or not uploadShifts(shifts)) {
+                return 0;
+            }
+            const opencl::cl_uint period = static_cast<opencl::cl_uint>(shifts.size());
+            const opencl::cl_int mirrored = reflect;
+            const opencl::cl_int inverse = decrypt;
+
+            std::array<std::size_t, 2> started{0, 0};  // input offset of the chunk in flight per slot
+            std::array<std::size_t, 2> lengths{0, 0};
+            std::array<opencl::cl_event, 2> done{nullptr, nullptr};
+            std::size_t completed = 0;
+            bool ok = true;
+            const auto drain = [&](const std::size_t s) {
+                if (done[s] == nullptr) {
+                    return;
+                }
+                ok = api.WaitForEvents(1, &done[s]) == opencl::SUCCESS and ok;
+                api.ReleaseEvent(done[s]);
+                done[s] = nullptr;
+                if (ok) {
+                    std::memcpy(out.data() + started[s], slots[s].host_out, lengths[s]);
+                    completed = started[s] + lengths[s];
+                }
+            };
+
+            std::size_t k = 0;
+            for (std::size_t begin = 0; begin < in.size() and ok; begin += OFFLOAD_CHUNK_BYTES, ++k) {
+                const std::size_t s = k % slots.size();
+                drain(s);
+                if (not ok) {
+                    break;
+                }
+                Slot& slot = slots[s];
+                const std::size_t count = std::min(OFFLOAD_CHUNK_BYTES, in.size() - begin);
+                // Stage from pageable memory into pinned memory while the
+                // other slot is busy on the device
+                std::memcpy(slot.host_in, in.data() + begin, count);
+                started[s] = begin;
+                lengths[s] = count;
+
+                const opencl::cl_uint phase = static_cast<opencl::cl_uint>((offset + begin) % shifts.size());
+                const opencl::cl_uint n = static_cast<opencl::cl_uint>(count);
+                const std::size_t global = (count + 255) / 256 * 256;
+                opencl::cl_event written = nullptr;
+                opencl::cl_event transformed = nullptr;
+                // Kernel arguments are captured at enqueue time
+                ok = api.EnqueueWriteBuffer(slot.queue, slot.device_in, opencl::FALSE, 0, count, slot.host_in, 0, nullptr, &written) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 0, sizeof(opencl::cl_mem), &slot.device_in) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 1, sizeof(opencl::cl_mem), &slot.device_out) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 2, sizeof(opencl::cl_mem), &shift_buffer) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 3, sizeof(period), &period) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 4, sizeof(phase), &phase) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 5, sizeof(mirrored), &mirrored) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 6, sizeof(inverse), &inverse) == opencl::SUCCESS
+                    and api.SetKernelArg(kernel, 7, sizeof(n), &n) == opencl::SUCCESS
+                    and api.EnqueueNDRangeKernel(slot.queue, kernel, 1, nullptr, &global, nullptr, 1, &written, &transformed) == opencl::SUCCESS
+                    and api.EnqueueReadBuffer(slot.queue, slot.device_out, opencl::FALSE, 0, count, slot.host_out, 1, &transformed, &done[s]) == opencl::SUCCESS;
+                if (written != nullptr) {
+                    api.ReleaseEvent(written);
+                }
+                if (transformed != nullptr) {
+                    api.ReleaseEvent(transformed);
+                }
+                ok = ok and api.Flush(slot.queue) == opencl::SUCCESS;
+            }
+            // Older chunk first: slot k % 2 holds chunk k - 2 when the
+            // loop ran to the end
+            for (std::size_t j = 0; j < slots.size(); ++j) {
+                const std::size_t s = (k + j) % slots.size();
+                drain(s);
+                api.Finish(slots[s].queue);
+            }
+            return ok ? in.size() : completed;
+        }
+
+    private:
+        /**
+         * Pinned host buffers (mapped once, for good) and device buffers
+         * of one transfer slot, with the queue that moves them
+         */
+        struct Slot {
+            opencl::cl_command_queue queue = nullptr;
+            opencl::cl_mem pinned_in = nullptr;
+            opencl::cl_mem pinned_out = nullptr;
+            opencl::cl_mem device_in = nullptr;
+            opencl::cl_mem device_out = nullptr;
+            void* host_in = nullptr;
+            void* host_out = nullptr;
+        };
+
+        opencl::Api api;
+        opencl::cl_device_id device = nullptr;
+        opencl::cl_context context = nullptr;
+        opencl::cl_program program = nullptr;
+        opencl::cl_kernel kernel = nullptr;
+        opencl::cl_mem shift_buffer = nullptr;
+        std::size_t shift_capacity = 0;
+        std::array<Slot, 2> slots{};
+        std::string device_name;
+        std::mutex mutex;
+
+        explicit OffloadDevice(const opencl::Api& runtime) : api(runtime) {}
+
+        [[nodiscard]] static std::unique_ptr<OffloadDevice> open() {
+            const std::optional<opencl::Api> runtime = opencl::Api::load();
+            if (not runtime) {
+                return nullptr;
+            }
+            std::unique_ptr<OffloadDevice> offload(new OffloadDevice(*runtime));
+            return offload->setUp() ? std::move(offload) : nullptr;
+        }
+
+        [[nodiscard]] bool findDevice() {
+            opencl::cl_uint platform_count = 0;
+            if (api.GetPlatformIDs(0, nullptr, &platform_count) != opencl::SUCCESS or platform_count == 0) {
+                return false;
+            }
+            std::vector<opencl::cl_platform_id> platforms(platform_count);
+            if (api.GetPlatformIDs(platform_count, platforms.data(), nullptr) != opencl::SUCCESS) {
+                return false;
+            }
+            for (const opencl::cl_bitfield type : {opencl::DEVICE_TYPE_GPU, opencl::DEVICE_TYPE_ACCELERATOR}) {
+                for (const opencl::cl_platform_id platform : platforms) {
+                    opencl::cl_uint count = 0;
+                    if (api.GetDeviceIDs(platform, type, 1, &device, &count) == opencl::SUCCESS and count > 0) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool setUp() {
+            if (not findDevice()) {
+                return false;
+            }
+            std::array<char, 256> label{};
+            if (api.GetDeviceInfo(device, opencl::DEVICE_NAME, label.size() - 1, label.data(), nullptr) == opencl::SUCCESS) {
+                device_name = label.data();
+            }
+
+            opencl::cl_int status = opencl::SUCCESS;
+            context = api.CreateContext(nullptr, 1, &device, nullptr, nullptr, &status);
+            if (status != opencl::SUCCESS) {
+                return false;
+            }
+            const char* source = opencl::KERNEL_SOURCE.data();
+            const std::size_t length = opencl::KERNEL_SOURCE.size();
+            program = api.CreateProgramWithSource(context, 1, &source, &length, &status);
+            if (status != opencl::SUCCESS or api.BuildProgram(program, 1, &device, "", nullptr, nullptr) != opencl::SUCCESS) {
+                return false;
+            }
+            kernel = api.CreateKernel(program, "affineLetters", &status);
+            if (status != opencl::SUCCESS) {
+                return false;
+            }
+
+            for (Slot& slot : slots) {
+                slot.queue = api.CreateCommandQueue(context, device, 0, &status);
+                if (status != opencl::SUCCESS) {
+                    return false;
+                }
+                const auto buffer = [&](const opencl::cl_bitfield flags) {
+                    opencl::cl_mem mem = api.CreateBuffer(context, flags, OFFLOAD_CHUNK_BYTES, nullptr, &status);
+                    return status == opencl::SUCCESS ? mem : nullptr;
+                };
+                slot.pinned_in = buffer(opencl::MEM_READ_WRITE | opencl::MEM_ALLOC_HOST_PTR);
+                slot.pinned_out = buffer(opencl::MEM_READ_WRITE | opencl::MEM_ALLOC_HOST_PTR);
+                slot.device_in = buffer(opencl::MEM_READ_ONLY);
+                slot.device_out = buffer(opencl::MEM_WRITE_ONLY);
+                if (slot.pinned_in == nullptr or slot.pinned_out == nullptr or slot.device_in == nullptr or slot.device_out == nullptr) {
+                    return false;
+                }
+                slot.host_in = api.EnqueueMapBuffer(slot.queue, slot.pinned_in, opencl::TRUE, opencl::MAP_WRITE, 0, OFFLOAD_CHUNK_BYTES, 0, nullptr, nullptr, &status);
+                if (status != opencl::SUCCESS) {
+                    return false;
+                }
+                slot.host_out = api.EnqueueMapBuffer(slot.queue, slot.pinned_out, opencl::TRUE, opencl::MAP_READ, 0, OFFLOAD_CHUNK_BYTES, 0, nullptr, nullptr, &status);
+                if (status != opencl::SUCCESS) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool uploadShifts(const std::span<const unsigned char> shifts) {
+            if (shifts.size() > shift_capacity) {
+                if (shift_buffer != nullptr) {
+                    api.ReleaseMemObject(shift_buffer);
+                }
+                opencl::cl_int status = opencl::SUCCESS;
+                shift_buffer = api.CreateBuffer(context, opencl::MEM_READ_ONLY, shifts.size(), nullptr, &status);
+                if (status != opencl::SUCCESS) {
+                    shift_buffer = nullptr;
+                    shift_capacity = 0;
+                    return false;
+                }
+                shift_capacity = shifts.size();
+            }
+            return api.EnqueueWriteBuffer(slots[0].queue, shift_buffer, opencl::TRUE, 0, shifts.size(), shifts.data(), 0, nullptr, nullptr) == opencl::SUCCESS;
+        }
+
+        void release() noexcept{
+            for (Slot& slot : slots) {
+                if (slot.host_in != nullptr) {
+                    api.EnqueueUnmapMemObject(slot.queue, slot.pinned_in, slot.host_in, 0, nullptr, nullptr);
+                }
+                if (slot.host_out != nullptr) {
+                    api.EnqueueUnmapMemObject(slot.queue, slot.pinned_out, slot.host_out, 0, nullptr, nullptr);
+                }
+                if (slot.queue != nullptr) {
+                    api.Finish(slot.queue);
+                }
+                for (const opencl::cl_mem mem : {slot.pinned_in, slot.pinned_out, slot.device_in, slot.device_out}) {
+                    if (mem != nullptr) {
+                        api.ReleaseMemObject(mem);
+                    }
+                }
+                if (slot.queue != nullptr) {
+                    api.ReleaseCommandQueue(slot.queue);
+                }
+            }
+            if (shift_buffer != nullptr) {
+                api.ReleaseMemObject(shift_buffer);
+            }
+            if (kernel != nullptr) {
+                api.ReleaseKernel(kernel);
+            }
+            if (program != nullptr) {
+                api.ReleaseProgram(program);
+            }
+            if (context != nullptr) {
+                api.ReleaseContext(context);
+            }
+        }
+};
+
+#endif
+
+/**
+ * Name of the device OffloadCipher uses, or nullopt when everything runs
+ * on the CPU
+ */
+[[nodiscard]] inline std::optional<std::string> offloadDeviceName() {
+#if CIPHERSUITE_HAS_OPENCL
+    if (const OffloadDevice* const device = OffloadDevice::shared()) {
+        return device->name();
+    }
+#endif
+    return std::nullopt;
+}
+
+class OffloadCipher final: public Encryption {
+    public:
+        /**
+         * @param cipher Caesar, Atbash, Vigenère, or a chain of them that
+         *               fuses into one pass (see supports()); also the CPU
+         *               fallback
+         * @param min_bytes Inputs below this size stay on the CPU
+         * @throws std::invalid_argument if cipher is not supported
+         */
+        explicit OffloadCipher(std::shared_ptr<const Encryption> cipher, const std::size_t min_bytes = OFFLOAD_MIN_BYTES)
+            : cpu(std::move(cipher)), threshold(min_bytes) {
+            const std::optional<AffineLetters> affine = cpu ? letterForm(*cpu) : std::nullopt;
+            if (not affine) {
+                throw std::invalid_argument("OffloadCipher: cipher is not a letter substitution");
+            }
+            reflect = affine->mirrored();
+            shifts.assign(affine->schedule().begin(), affine->schedule().end());
+        }
+
+        /**
+         * Whether cipher has a form the device kernel runs
+         */
+        [[nodiscard]] static bool supports(const Encryption& cipher) {
+            return letterForm(cipher).has_value();
+        }
+
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return cpu->name();
+        }
+
+        [[nodiscard]] bool positionIndependent() const noexcept override{
+            return cpu->positionIndependent();
+        }
+
+        /**
+         * Whether inputs of n bytes would go to the device
+         */
+        [[nodiscard]] bool offloads(const std::size_t n) const{
+            return n >= threshold and offloadDeviceName().has_value();
+        }
+
+    protected:
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset) const noexcept override{
+#if CIPHERSUITE_HAS_OPENCL
+            if (in.size() >= threshold) {
+                OffloadDevice* device = nullptr;
+                try {
+                    device = OffloadDevice::shared();
+                }
+                catch (...) {
+                }
+                const std::size_t done = device != nullptr ? device->transform(in, out, reflect, d == Direction::decrypt, shifts, offset) : 0;
+                if (done == in.size()) {
+                    return done;
+                }
+                // out[0, done) is final, and may already overwrite in
+                return done + cpu->transform(in.subspan(done), out.subspan(done), d, offset + done);
+            }
+#endif
+            return cpu->transform(in, out, d, offset);
+        }
+
+    private:
+        std::shared_ptr<const Encryption> cpu;
+        std::size_t threshold;
+        bool reflect = false;
+        std::vector<unsigned char> shifts;
+
+        [[nodiscard]] static std::optional<AffineLetters> letterForm(const Encryption& cipher) {
+            if (const auto* const pipeline = dynamic_cast<const CipherPipeline*>(&cipher)) {
+                return pipeline->fused();
+            }
+            return AffineLetters::of(cipher);
+        }
+};
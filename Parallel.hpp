@@ -0,0 +1,86 @@
+/**
+ * @file Parallel.hpp
+ * @brief Chunk-Parallel Transform Driver
+ *
+ * Every cipher in the suite is position-local: a chunk can be transformed
+ * on its own once its offset in the stream is known (Vigenère derives the
+ * key phase from it) and its boundaries sit where the cipher allows a
+ * split (splitPoint()). This driver cuts a large buffer into cache-sized
+ * chunks and spreads them across a ThreadPool.
+ *
+ * Length-preserving ciphers write each chunk straight to its final
+ * location. A1Z26 first sizes every chunk in parallel, then places the
+ * chunks by prefix sum and transforms them in a second parallel pass.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include "ThreadPool.hpp"
+#include<cstddef>
+#include<span>
+#include<stdexcept>
+#include<vector>
+
+
+/**
+ * Chunk size handed to one thread at a time: large enough to amortize
+ * scheduling, small enough to stay resident in L2
+ */
+inline constexpr std::size_t PARALLEL_CHUNK_SIZE = std::size_t{1} << 18;
+
+/**
+ * Parallel counterpart of Encryption::transform()
+ * @param cipher Configured cipher; only const members are used
+ * @param in Source bytes
+ * @param out Destination, at least cipher.transformedSize(in) long; may
+ *            alias in for length-preserving ciphers
+ * @param d Encrypt or decrypt
+ * @param offset Position of in[0] within the overall stream
+ * @param pool Threads to run on
+ * @param chunk_size Target bytes per task
+ * @return Number of bytes written to out
+ * @throws std::length_error if out is too small
+ */
+inline std::size_t parallelTransform(const Encryption& cipher, const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset = 0, ThreadPool& pool = sharedThreadPool(), const std::size_t chunk_size = PARALLEL_CHUNK_SIZE) {
+    if (pool.workerCount() == 0 or in.size() <= chunk_size) {
+        return cipher.transform(in, out, d, offset);
+    }
+
+    std::vector<std::size_t> bounds{0};
+    while (bounds.back() < in.size()) {
+        bounds.push_back(cipher.splitPoint(in, bounds.back() + chunk_size, d));
+    }
+    const std::size_t chunks = bounds.size() - 1;
+    const auto piece = [&](const std::size_t c) {
+        return in.subspan(bounds[c], bounds[c + 1] - bounds[c]);
+    };
+
+    if (cipher.preservesLength()) {
+        if (out.size() < in.size()) {
+            throw std::length_error("parallelTransform: output buffer too small");
+        }
+        pool.parallelFor(chunks, [&](const std::size_t c) {
+            cipher.transform(piece(c), out.subspan(bounds[c], bounds[c + 1] - bounds[c]), d, offset + bounds[c]);
+        });
+        return in.size();
+    }
+
+    std::vector<std::size_t> placed(chunks + 1, 0);
+    pool.parallelFor(chunks, [&](const std::size_t c) {
+        placed[c + 1] = cipher.transformedSize(piece(c), d, offset + bounds[c]);
+    });
+    for (std::size_t c = 0; c < chunks; ++c) {
+        placed[c + 1] += placed[c];
+    }
+    if (out.size() < placed.back()) {
+        throw std::length_error("parallelTransform: output buffer too small");
+    }
+    pool.parallelFor(chunks, [&](const std::size_t c) {
+        cipher.transform(piece(c), out.subspan(placed[c], placed[c + 1] - placed[c]), d, offset + bounds[c]);
+    });
+    return placed.back();
+}
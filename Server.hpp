@@ -0,0 +1,718 @@
+/**
+ * @file Server.hpp
+ * @brief Socket Server for Long-Running Encryption Services
+ *
+ * Keeps the cipher engines warm in one process so callers pay a socket
+ * round trip per message instead of a fork/exec.
+ *
+ * Protocol (all integers big-endian), one frame per message:
+ *   request:  u32 length | u32 id | u8 direction | u8 cipher | u16 key length | key | payload
+ *   response: u32 length | u32 id | u8 status | payload
+ * length counts the bytes after itself. direction is 0 for encrypt and
+ * 1 for decrypt, cipher is a CipherId (0 caesar, 1 vigenere, 2 a1z26,
+ * 3 atbash), id is echoed back. Clients may pipeline any number of
+ * requests; responses on a connection come back in request order.
+ *
+ * Features:
+ * - One epoll loop accepts connections and does all socket I/O
+ * - Complete frames that arrive together are handed to a fixed worker
+ *   pool as one batch, and the batch's responses go out in one send()
+ * - Prepared ciphers are shared through CipherCache, so a repeated
+ *   (cipher, key) pair costs a hash lookup
+ * - One batch in flight per connection: reading pauses until it is
+ *   answered, which keeps responses in order and bounds buffering
+ * - Unix ("unix:/path") and TCP ("tcp:host:port" or "host:port")
+ *   listeners; CipherClient speaks the same protocol
+ * - Linux only (epoll, eventfd); CIPHERSUITE_HAS_SERVER is 0 elsewhere
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherCache.hpp"
+#include "CipherFactory.hpp"
+#include "ThreadPool.hpp"
+#include<algorithm>
+#include<atomic>
+#include<cerrno>
+#include<cstddef>
+#include<cstdint>
+#include<mutex>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<system_error>
+#include<unordered_map>
+#include<utility>
+#include<vector>
+
+#if __has_include(<sys/epoll.h>) and __has_include(<sys/eventfd.h>)
+#define CIPHERSUITE_HAS_SERVER 1
+#include<fcntl.h>
+#include<netdb.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include<sys/epoll.h>
+#include<sys/eventfd.h>
+#include<sys/socket.h>
+#include<sys/stat.h>
+#include<sys/un.h>
+#include<unistd.h>
+#else
+#define CIPHERSUITE_HAS_SERVER 0
+#endif
+
+
+/**
+ * Size of the length prefix in front of every frame
+ */
+inline constexpr std::size_t FRAME_PREFIX_BYTES = 4;
+
+/**
+ * Request fields between the length prefix and the key
+ */
+inline constexpr std::size_t REQUEST_HEADER_BYTES = 8;
+
+/**
+ * Response fields between the length prefix and the payload
+ */
+inline constexpr std::size_t RESPONSE_HEADER_BYTES = 5;
+
+/**
+ * Largest frame the server accepts; bigger ones end the connection
+ */
+inline constexpr std::size_t MAX_FRAME_BYTES = 16 << 20;
+
+/**
+ * Request bytes handed to a worker at once: enough to amortize the
+ * hand-off, small enough to spread a pipelined burst over the pool
+ */
+inline constexpr std::size_t SERVER_BATCH_BYTES = 256 << 10;
+
+/**
+ * internal_error: the request could not be served (out of memory); the
+ * connection and the rest of its batch carry on
+ */
+enum class ServerStatus : std::uint8_t { ok, malformed, unknown_cipher, invalid_key, too_large, internal_error };
+
+struct ServerRequest {
+    std::uint32_t id = 0;
+    Direction direction = Direction::encrypt;
+    CipherId cipher = CipherId::caesar;
+    std::string_view key;
+    std::string_view payload;
+};
+
+struct ServerResponse {
+    std::uint32_t id = 0;
+    ServerStatus status = ServerStatus::ok;
+    std::string payload;
+};
+
+inline void storeBigEndian(char* const p, const std::uint32_t value, const std::size_t bytes) noexcept{
+    for (std::size_t i = 0; i < bytes; ++i) {
+        p[i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+    }
+}
+
+[[nodiscard]] inline std::uint32_t loadBigEndian(const char* const p, const std::size_t bytes) noexcept{
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        value = value << 8 | static_cast<unsigned char>(p[i]);
+    }
+    return value;
+}
+
+/**
+ * Appends request as one frame to out
+ * @throws std::length_error if the key or payload does not fit a frame
+ */
+inline void appendRequest(std::string& out, const ServerRequest& request) {
+    if (request.key.size() > 0xFFFF or request.payload.size() > MAX_FRAME_BYTES - REQUEST_HEADER_BYTES - request.key.size()) {
+        throw std::length_error("Request does not fit in a frame");
+    }
+    const std::size_t at = out.size();
+    out.resize(at + FRAME_PREFIX_BYTES + REQUEST_HEADER_BYTES);
+    char* const p = out.data() + at;
+    storeBigEndian(p, static_cast<std::uint32_t>(REQUEST_HEADER_BYTES + request.key.size() + request.payload.size()), 4);
+    storeBigEndian(p + 4, request.id, 4);
+    p[8] = static_cast<char>(request.direction);
+    p[9] = static_cast<char>(request.cipher);
+    storeBigEndian(p + 10, static_cast<std::uint32_t>(request.key.size()), 2);
+    out.append(request.key);
+    out.append(request.payload);
+}
+
+/**
+ * Appends a response frame to out
+ */
+inline void appendResponse(std::string& out, const std::uint32_t id, const ServerStatus status, const std::string_view payload = {}) {
+    const std::size_t at = out.size();
+    out.resize(at + FRAME_PREFIX_BYTES + RESPONSE_HEADER_BYTES);
+    char* const p = out.data() + at;
+    storeBigEndian(p, static_cast<std::uint32_t>(RESPONSE_HEADER_BYTES + payload.size()), 4);
+    storeBigEndian(p + 4, id, 4);
+    p[8] = static_cast<char>(status);
+    out.append(payload);
+}
+
+/**
+ * Length of the complete frame at the start of buffer
+ * @return Bytes including the prefix, 0 if more input is needed, or
+ *         SIZE_MAX if the announced length exceeds max_frame
+ */
+[[nodiscard]] inline std::size_t completeFrame(const std::span<const char> buffer, const std::size_t max_frame = MAX_FRAME_BYTES) noexcept{
+    if (buffer.size() < FRAME_PREFIX_BYTES) {
+        return 0;
+    }
+    const std::size_t length = loadBigEndian(buffer.data(), 4);
+    if (length > max_frame) {
+        return SIZE_MAX;
+    }
+    return buffer.size() - FRAME_PREFIX_BYTES >= length ? FRAME_PREFIX_BYTES + length : 0;
+}
+
+/**
+ * Transforms the request in one complete frame and appends the response
+ * @param frame Frame including its length prefix
+ */
+inline void serveRequest(const std::span<const char> frame, std::string& out, CipherCache& cache = sharedCipherCache()) {
+    const std::size_t length = frame.size() - FRAME_PREFIX_BYTES;
+    const std::uint32_t id = length >= 4 ? loadBigEndian(frame.data() + 4, 4) : 0;
+    if (length < REQUEST_HEADER_BYTES) {
+        appendResponse(out, id, ServerStatus::malformed);
+        return;
+    }
+    const char* const p = frame.data();
+    const std::size_t key_length = loadBigEndian(p + 10, 2);
+    const unsigned direction = static_cast<unsigned char>(p[8]);
+    const unsigned cipher_id = static_cast<unsigned char>(p[9]);
+    if (direction > 1 or key_length > length - REQUEST_HEADER_BYTES) {
+        appendResponse(out, id, ServerStatus::malformed);
+        return;
+    }
+    if (cipher_id > static_cast<unsigned>(CipherId::atbash)) {
+        appendResponse(out, id, ServerStatus::unknown_cipher);
+        return;
+    }
+    const char* const key = p + FRAME_PREFIX_BYTES + REQUEST_HEADER_BYTES;
+    const std::shared_ptr<const Encryption> cipher = cache.get(static_cast<CipherId>(cipher_id), {key, key_length});
+    if (not cipher) {
+        appendResponse(out, id, ServerStatus::invalid_key);
+        return;
+    }
+
+    const std::span<const char> payload(key + key_length, length - REQUEST_HEADER_BYTES - key_length);
+    const Direction d = direction == 0 ? Direction::encrypt : Direction::decrypt;
+    const std::size_t size = cipher->transformedSize(payload, d);
+    const std::size_t at = out.size();
+    appendResponse(out, id, ServerStatus::ok);
+    out.resize(out.size() + size);
+    cipher->transform(payload, std::span(out).subspan(out.size() - size), d);
+    storeBigEndian(out.data() + at, static_cast<std::uint32_t>(RESPONSE_HEADER_BYTES + size), 4);
+}
+
+/**
+ * Server tuning
+ */
+struct ServerOptions {
+    unsigned workers = hardwareThreads();      // threads running the ciphers
+    std::size_t max_frame = MAX_FRAME_BYTES;   // largest accepted request frame
+    std::size_t batch_bytes = SERVER_BATCH_BYTES;
+};
+
+#if CIPHERSUITE_HAS_SERVER
+
+/**
+ * Socket for "unix:/path", "tcp:host:port" or "host:port"
+ * @param listening Bind and listen (a stale Unix socket file is replaced)
+ *                  instead of connecting
+ * @throws std::invalid_argument for a malformed address
+ * @throws std::system_error if the socket cannot be set up
+ */
+[[nodiscard]] inline int openSocket(const std::string_view address, const bool listening) {
+    const auto fail = [&](const int fd, const char* const what) {
+        const int error = errno;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::system_error(error, std::generic_category(), std::string(what) + " " + std::string(address));
+    };
+
+    if (address.starts_with("unix:")) {
+        const std::string_view path = address.substr(5);
+        sockaddr_un local{};
+        local.sun_family = AF_UNIX;
+        if (path.empty() or path.size() >= sizeof(local.sun_path)) {
+            throw std::invalid_argument("Invalid socket path '" + std::string(path) + "'");
+        }
+        path.copy(local.sun_path, path.size());
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            fail(fd, "Cannot create socket for");
+        }
+        if (not listening) {
+            if (::connect(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0) {
+                fail(fd, "Cannot connect to");
+            }
+            return fd;
+        }
+        struct stat info{};
+        if (::stat(local.sun_path, &info) == 0 and S_ISSOCK(info.st_mode)) {
+            ::unlink(local.sun_path);
+        }
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0 or ::listen(fd, SOMAXCONN) != 0) {
+            fail(fd, "Cannot listen on");
+        }
+        return fd;
+    }
+
+    const std::string_view host_port = address.starts_with("tcp:") ? address.substr(4) : address;
+    const std::size_t colon = host_port.rfind(':');
+    if (colon == std::string_view::npos or colon + 1 == host_port.size()) {
+        throw std::invalid_argument("Invalid address '" + std::string(address) + "'");
+    }
+    const std::string host(host_port.substr(0, colon));
+    const std::string port(host_port.substr(colon + 1));
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    addrinfo* found = nullptr;
+    if (const int rc = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found); rc != 0) {
+        throw std::invalid_argument("Cannot resolve '" + std::string(address) + "': " + ::gai_strerror(rc));
+    }
+    int fd = -1;
+    for (const addrinfo* ai = found; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        const int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (listening) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 and ::listen(fd, SOMAXCONN) == 0) {
+                break;
+            }
+        }
+        else if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(found);
+    if (fd < 0) {
+        fail(fd, listening ? "Cannot listen on" : "Cannot connect to");
+    }
+    return fd;
+}
+
+class CipherServer {
+    public:
+        /**
+         * @param listen_fd Listening socket, owned by the server from now on
+         * @param cache Where prepared ciphers are looked up
+         * @throws std::system_error if epoll or eventfd cannot be set up
+         */
+        explicit CipherServer(const int listen_fd, const ServerOptions options = {}, CipherCache& cache = sharedCipherCache())
+            : settings(options), ciphers(cache), listener(listen_fd), pool(options.workers) {
+            if (::fcntl(listener, F_SETFL, ::fcntl(listener, F_GETFL) | O_NONBLOCK) != 0
+                or (events = ::epoll_create1(EPOLL_CLOEXEC)) < 0
+                or (wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+                const int error = errno;
+                closeAll();
+                throw std::system_error(error, std::generic_category(), "Cannot set up server");
+            }
+            watch(listener, LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+            watch(wake, WAKE, EPOLLIN, EPOLL_CTL_ADD);
+        }
+
+        CipherServer(const CipherServer&) = delete;
+        CipherServer& operator=(const CipherServer&) = delete;
+
+        ~CipherServer() {
+            closeAll();
+        }
+
+        /**
+         * Serves connections until stop() is called
+         * @throws std::system_error if epoll fails
+         */
+        void run() {
+            std::vector<epoll_event> ready(64);
+            while (not stopping.load(std::memory_order_relaxed)) {
+                const int n = ::epoll_wait(events, ready.data(), static_cast<int>(ready.size()), -1);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "epoll_wait failed");
+                }
+                for (int i = 0; i < n; ++i) {
+                    const std::uint64_t id = ready[i].data.u64;
+                    if (id == LISTENER) {
+                        acceptAll();
+                    }
+                    else if (id == WAKE) {
+                        drainCompletions();
+                    }
+                    else if (const auto found = connections.find(id); found != connections.end()) {
+                        service(found->first, found->second, ready[i].events);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Makes run() return; safe from other threads and signal handlers
+         */
+        void stop() noexcept{
+            stopping.store(true, std::memory_order_relaxed);
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const auto written = ::write(wake, &one, sizeof(one));
+        }
+
+        /**
+         * Connections currently open
+         */
+        [[nodiscard]] std::size_t connectionCount() const noexcept{
+            return connections.size();
+        }
+
+    private:
+        static constexpr std::uint64_t LISTENER = 0;
+        static constexpr std::uint64_t WAKE = 1;
+        static constexpr std::size_t READ_BYTES = 64 << 10;
+
+        struct Connection {
+            int fd = -1;
+            std::vector<char> in;       // unparsed request bytes
+            std::string out;            // responses not yet sent
+            std::size_t sent = 0;       // bytes of out already sent
+            bool busy = false;          // a batch is with the workers
+            bool eof = false;           // peer will send nothing more
+            bool failed = false;        // close without flushing
+            bool watched = true;        // registered with epoll
+        };
+
+        struct Completion {
+            std::uint64_t id;
+            std::string responses;
+            bool failed = false;        // the batch could not be answered
+        };
+
+        ServerOptions settings;
+        CipherCache& ciphers;
+        int listener = -1;
+        int events = -1;
+        int wake = -1;
+        std::atomic<bool> stopping{false};
+        std::uint64_t next_id = WAKE + 1;
+        std::unordered_map<std::uint64_t, Connection> connections;
+        std::mutex completed_mutex;
+        std::vector<Completion> completed;
+        // Last, so workers finish before the state they report to goes away
+        ThreadPool pool;
+
+        void closeAll() noexcept{
+            for (auto& [id, connection] : connections) {
+                ::close(connection.fd);
+            }
+            connections.clear();
+            for (const int fd : {listener, events, wake}) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+            listener = events = wake = -1;
+        }
+
+        void watch(const int fd, const std::uint64_t id, const std::uint32_t mask, const int op) {
+            epoll_event event{};
+            event.events = mask;
+            event.data.u64 = id;
+            if (::epoll_ctl(events, op, fd, &event) != 0) {
+                throw std::system_error(errno, std::generic_category(), "epoll_ctl failed");
+            }
+        }
+
+        void acceptAll() {
+            for (;;) {
+                const int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    // EAGAIN: backlog drained. Anything else (EMFILE, a
+                    // connection reset before accept) drops one client,
+                    // not the server
+                    return;
+                }
+                const int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                const std::uint64_t id = next_id++;
+                connections[id].fd = fd;
+                watch(fd, id, EPOLLIN, EPOLL_CTL_ADD);
+            }
+        }
+
+        void service(const std::uint64_t id, Connection& connection, const std::uint32_t ready) {
+            if (ready & EPOLLERR) {
+                connection.failed = true;
+            }
+            else {
+                if (ready & (EPOLLIN | EPOLLHUP)) {
+                    receive(connection);
+                }
+                if (ready & EPOLLOUT) {
+                    flush(connection);
+                }
+            }
+            settle(id, connection);
+        }
+
+        /**
+         * Reads what the socket holds, up to one largest frame plus one
+         * batch; epoll (level-triggered) reports the rest on a later turn,
+         * so a peer that keeps its socket full neither starves the other
+         * connections nor grows in without bound
+         */
+        void receive(Connection& connection) {
+            const std::size_t limit = FRAME_PREFIX_BYTES + settings.max_frame + settings.batch_bytes;
+            while (connection.in.size() < limit) {
+                const std::size_t used = connection.in.size();
+                const std::size_t want = std::min(READ_BYTES, limit - used);
+                connection.in.resize(used + want);
+                const ssize_t got = ::recv(connection.fd, connection.in.data() + used, want, 0);
+                connection.in.resize(used + static_cast<std::size_t>(std::max<ssize_t>(got, 0)));
+                if (got == 0) {
+                    connection.eof = true;
+                    return;
+                }
+                if (got < 0) {
+                    connection.failed = errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR;
+                    return;
+                }
+                if (static_cast<std::size_t>(got) < want) {
+                    return;
+                }
+            }
+        }
+
+        void flush(Connection& connection) {
+            while (connection.sent < connection.out.size()) {
+                const ssize_t put = ::send(connection.fd, connection.out.data() + connection.sent, connection.out.size() - connection.sent, MSG_NOSIGNAL);
+                if (put < 0) {
+                    connection.failed = errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR;
+                    return;
+                }
+                connection.sent += static_cast<std::size_t>(put);
+            }
+            connection.out.clear();
+            connection.sent = 0;
+        }
+
+        /**
+         * Hands the next batch of complete frames to the pool, if any
+         */
+        void dispatch(const std::uint64_t id, Connection& connection) {
+            if (connection.busy or connection.failed) {
+                return;
+            }
+            const std::span<const char> buffered(connection.in);
+            std::size_t taken = 0;
+            while (taken < buffered.size() and taken < settings.batch_bytes) {
+                const std::size_t frame = completeFrame(buffered.subspan(taken), settings.max_frame);
+                if (frame == SIZE_MAX and taken == 0) {
+                    // The peer cannot be resynchronized: report the
+                    // oversized frame and hang up once it is sent
+                    appendResponse(connection.out, 0, ServerStatus::too_large);
+                    connection.eof = true;
+                    connection.in.clear();
+                    return;
+                }
+                if (frame == 0 or frame == SIZE_MAX) {
+                    break;   // an oversized frame waits until what precedes it is answered
+                }
+                taken += frame;
+            }
+            if (taken == 0) {
+                return;
+            }
+
+            std::vector<char> batch;
+            if (taken == connection.in.size()) {
+                batch.swap(connection.in);
+            }
+            else {
+                batch.assign(connection.in.begin(), connection.in.begin() + static_cast<std::ptrdiff_t>(taken));
+                connection.in.erase(connection.in.begin(), connection.in.begin() + static_cast<std::ptrdiff_t>(taken));
+            }
+            connection.busy = true;
+            pool.submit([this, id, batch = std::move(batch)] {
+                // The pool has no handler, so an exception escaping here
+                // would end the process: a request that throws gets
+                // internal_error, and a batch that cannot even say so
+                // closes its connection
+                std::string responses;
+                bool failed = false;
+                try {
+                    for (std::size_t at = 0; at < batch.size();) {
+                        const std::size_t frame = FRAME_PREFIX_BYTES + loadBigEndian(batch.data() + at, 4);
+                        const std::size_t answered = responses.size();
+                        try {
+                            serveRequest(std::span(batch).subspan(at, frame), responses, ciphers);
+                        }
+                        catch (const std::exception&) {
+                            responses.resize(answered);
+                            appendResponse(responses, frame >= FRAME_PREFIX_BYTES + 4 ? loadBigEndian(batch.data() + at + 4, 4) : 0, ServerStatus::internal_error);
+                        }
+                        at += frame;
+                    }
+                }
+                catch (const std::exception&) {
+                    responses.clear();
+                    failed = true;
+                }
+                {
+                    const std::lock_guard lock(completed_mutex);
+                    completed.push_back({id, std::move(responses), failed});
+                }
+                const std::uint64_t one = 1;
+                [[maybe_unused]] const auto written = ::write(wake, &one, sizeof(one));
+            });
+        }
+
+        void drainCompletions() {
+            std::uint64_t count = 0;
+            [[maybe_unused]] const auto drained = ::read(wake, &count, sizeof(count));
+            std::vector<Completion> done;
+            {
+                const std::lock_guard lock(completed_mutex);
+                done.swap(completed);
+            }
+            for (Completion& completion : done) {
+                const auto found = connections.find(completion.id);
+                if (found == connections.end()) {
+                    continue;   // closed while its batch was running
+                }
+                Connection& connection = found->second;
+                connection.busy = false;
+                connection.failed = connection.failed or completion.failed;
+                if (connection.out.empty()) {
+                    connection.out.swap(completion.responses);
+                }
+                else {
+                    connection.out.append(completion.responses);
+                }
+                flush(connection);
+                settle(completion.id, connection);
+            }
+        }
+
+        /**
+         * Dispatches buffered work, then closes the connection or updates
+         * what epoll should report for it
+         */
+        void settle(const std::uint64_t id, Connection& connection) {
+            dispatch(id, connection);
+            const bool pending = connection.sent < connection.out.size();
+            if (connection.failed or (connection.eof and not connection.busy and not pending)) {
+                ::close(connection.fd);
+                connections.erase(id);
+                return;
+            }
+            // With nothing to wait for, the descriptor leaves the epoll set
+            // entirely: a hung-up peer would otherwise report EPOLLHUP over
+            // and over while its batch runs
+            const std::uint32_t mask = (connection.busy or connection.eof ? 0u : static_cast<std::uint32_t>(EPOLLIN)) | (pending ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+            if (mask != 0) {
+                watch(connection.fd, id, mask, connection.watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD);
+            }
+            else if (connection.watched) {
+                ::epoll_ctl(events, EPOLL_CTL_DEL, connection.fd, nullptr);
+            }
+            connection.watched = mask != 0;
+        }
+};
+
+class CipherClient {
+    public:
+        /**
+         * @param address As for openSocket()
+         * @throws std::system_error if the server cannot be reached
+         */
+        explicit CipherClient(const std::string_view address) : fd(openSocket(address, false)) {}
+
+        CipherClient(const CipherClient&) = delete;
+        CipherClient& operator=(const CipherClient&) = delete;
+
+        ~CipherClient() {
+            ::close(fd);
+        }
+
+        /**
+         * Sends all requests in one write and waits for every response
+         * @throws std::system_error on a socket error or a closed connection
+         */
+        [[nodiscard]] std::vector<ServerResponse> call(const std::span<const ServerRequest> requests) {
+            pending.clear();
+            for (const ServerRequest& request : requests) {
+                appendRequest(pending, request);
+            }
+            for (std::size_t sent = 0; sent < pending.size();) {
+                const ssize_t put = ::send(fd, pending.data() + sent, pending.size() - sent, MSG_NOSIGNAL);
+                if (put < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "Cannot send request");
+                }
+                sent += static_cast<std::size_t>(put);
+            }
+
+            std::vector<ServerResponse> responses(requests.size());
+            for (ServerResponse& response : responses) {
+                char header[FRAME_PREFIX_BYTES + RESPONSE_HEADER_BYTES];
+                receiveExactly(header, sizeof(header));
+                const std::size_t length = loadBigEndian(header, 4);
+                if (length < RESPONSE_HEADER_BYTES) {
+                    throw std::system_error(std::make_error_code(std::errc::protocol_error), "Malformed response");
+                }
+                response.id = loadBigEndian(header + 4, 4);
+                response.status = static_cast<ServerStatus>(static_cast<unsigned char>(header[8]));
+                response.payload.resize(length - RESPONSE_HEADER_BYTES);
+                receiveExactly(response.payload.data(), response.payload.size());
+            }
+            return responses;
+        }
+
+        [[nodiscard]] ServerResponse call(const ServerRequest& request) {
+            return std::move(call(std::span(&request, 1)).front());
+        }
+
+    private:
+        int fd;
+        std::string pending;
+
+        void receiveExactly(char* p, std::size_t n) {
+            while (n > 0) {
+                const ssize_t got = ::recv(fd, p, n, 0);
+                if (got == 0) {
+                    throw std::system_error(std::make_error_code(std::errc::connection_reset), "Server closed the connection");
+                }
+                if (got < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "Cannot receive response");
+                }
+                p += got;
+                n -= static_cast<std::size_t>(got);
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,667 @@
+/**
+ * @file Simd.hpp
+ * @brief Vectorized Kernels for the Substitution Ciphers
+ *
+ * Caesar, Vigenère and Atbash only ever add a per-letter delta to ASCII
+ * letters, which maps directly onto SIMD compare/add/mask. Each kernel
+ * processes whole vectors and returns how many bytes it handled; callers
+ * finish the tail (and the whole input on the scalar level) with their
+ * scalar code, so output is identical on every level.
+ *
+ * Per vector:
+ *   u     = v & ~0x20             fold lowercase onto uppercase
+ *   idx   = u - 'A'               letter index, 0..25 for letters only
+ *   mask  = idx <= 25 (unsigned)  letter lanes
+ *   out   = v + (mask & delta)    delta depends on the cipher
+ *
+ * Features:
+ * - SSE2 (x86-64 baseline), AVX2 (runtime-detected), NEON (AArch64)
+ * - Dispatch on the best level the CPU supports, chosen once
+ * - Every level callable explicitly, for benchmarks and equivalence tests
+ * - A1Z26 encode/decode kernels (AVX2 level, SSSE3 shuffles): letters
+ *   widen to digit pairs and digit pairs pack back through per-mask
+ *   shuffle tables
+ * - Build with -DCIPHERSUITE_NO_SIMD to force the scalar tables
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<array>
+#include<bit>
+#include<cstddef>
+#include<cstdint>
+#include<initializer_list>
+#include<span>
+#include<string_view>
+
+#if not defined(CIPHERSUITE_NO_SIMD)
+#if defined(__x86_64__) or defined(_M_X64)
+#define CIPHERSUITE_SIMD_X86 1
+#include<immintrin.h>
+#if defined(__GNUC__)
+#define CIPHERSUITE_SIMD_AVX2 1
+#define CIPHERSUITE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) or defined(_M_ARM64)
+#define CIPHERSUITE_SIMD_NEON 1
+#include<arm_neon.h>
+#endif
+#endif
+
+
+enum class SimdLevel { scalar, sse2, avx2, neon };
+
+[[nodiscard]] constexpr std::string_view simdLevelName(const SimdLevel level) noexcept{
+    switch (level) {
+        case SimdLevel::sse2: return "sse2";
+        case SimdLevel::avx2: return "avx2";
+        case SimdLevel::neon: return "neon";
+        case SimdLevel::scalar: break;
+    }
+    return "scalar";
+}
+
+[[nodiscard]] inline bool simdLevelSupported(const SimdLevel level) noexcept{
+    switch (level) {
+        case SimdLevel::scalar:
+            return true;
+#if defined(CIPHERSUITE_SIMD_X86)
+        case SimdLevel::sse2:
+            return true;
+#endif
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(CIPHERSUITE_SIMD_NEON)
+        case SimdLevel::neon:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * Widest level available on this CPU, detected on first use
+ */
+[[nodiscard]] inline SimdLevel bestSimdLevel() noexcept{
+    static const SimdLevel best = [] {
+        for (const SimdLevel level : {SimdLevel::avx2, SimdLevel::neon, SimdLevel::sse2}) {
+            if (simdLevelSupported(level)) {
+                return level;
+            }
+        }
+        return SimdLevel::scalar;
+    }();
+    return best;
+}
+
+namespace simd {
+
+#if defined(CIPHERSUITE_SIMD_X86)
+inline __m128i letterIndexSse2(const __m128i v, __m128i& mask) noexcept{
+    const __m128i idx = _mm_sub_epi8(_mm_and_si128(v, _mm_set1_epi8(~0x20)), _mm_set1_epi8('A'));
+    mask = _mm_cmpeq_epi8(_mm_min_epu8(idx, _mm_set1_epi8(25)), idx);
+    return idx;
+}
+
+/**
+ * Shifts letter lanes of v by the per-lane amounts in shift (0..25)
+ */
+inline __m128i shiftSse2(const __m128i v, const __m128i shift) noexcept{
+    __m128i mask;
+    const __m128i idx = letterIndexSse2(v, mask);
+    const __m128i wrap = _mm_cmpgt_epi8(_mm_add_epi8(idx, shift), _mm_set1_epi8(25));
+    const __m128i delta = _mm_sub_epi8(shift, _mm_and_si128(wrap, _mm_set1_epi8(26)));
+    return _mm_add_epi8(v, _mm_and_si128(mask, delta));
+}
+
+inline __m128i reverseSse2(const __m128i v) noexcept{
+    __m128i mask;
+    const __m128i idx = letterIndexSse2(v, mask);
+    const __m128i delta = _mm_sub_epi8(_mm_set1_epi8(25), _mm_add_epi8(idx, idx));
+    return _mm_add_epi8(v, _mm_and_si128(mask, delta));
+}
+
+inline std::size_t shiftLettersSse2(const char* in, char* out, const std::size_t n, const int shift) noexcept{
+    const __m128i s = _mm_set1_epi8(static_cast<char>(shift));
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), shiftSse2(v, s));
+    }
+    return i;
+}
+
+inline std::size_t shiftLettersStreamSse2(const char* in, char* out, const std::size_t n, const unsigned char* stream, const std::size_t period, std::size_t& phase) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stream + phase));
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), shiftSse2(v, s));
+        phase += 16;
+        if (phase >= period) {
+            phase -= period;
+        }
+    }
+    return i;
+}
+
+inline std::size_t reverseLettersSse2(const char* in, char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), reverseSse2(v));
+    }
+    return i;
+}
+
+inline std::size_t letterIndicesSse2(const char* in, unsigned char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i mask;
+        const __m128i idx = letterIndexSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(idx, _mm_andnot_si128(mask, _mm_set1_epi8(-1))));
+    }
+    return i;
+}
+#endif
+
+#if defined(CIPHERSUITE_SIMD_AVX2)
+CIPHERSUITE_TARGET_AVX2 inline __m256i letterIndexAvx2(const __m256i v, __m256i& mask) noexcept{
+    const __m256i idx = _mm256_sub_epi8(_mm256_and_si256(v, _mm256_set1_epi8(~0x20)), _mm256_set1_epi8('A'));
+    mask = _mm256_cmpeq_epi8(_mm256_min_epu8(idx, _mm256_set1_epi8(25)), idx);
+    return idx;
+}
+
+CIPHERSUITE_TARGET_AVX2 inline __m256i shiftAvx2(const __m256i v, const __m256i shift) noexcept{
+    __m256i mask;
+    const __m256i idx = letterIndexAvx2(v, mask);
+    const __m256i wrap = _mm256_cmpgt_epi8(_mm256_add_epi8(idx, shift), _mm256_set1_epi8(25));
+    const __m256i delta = _mm256_sub_epi8(shift, _mm256_and_si256(wrap, _mm256_set1_epi8(26)));
+    return _mm256_add_epi8(v, _mm256_and_si256(mask, delta));
+}
+
+CIPHERSUITE_TARGET_AVX2 inline __m256i reverseAvx2(const __m256i v) noexcept{
+    __m256i mask;
+    const __m256i idx = letterIndexAvx2(v, mask);
+    const __m256i delta = _mm256_sub_epi8(_mm256_set1_epi8(25), _mm256_add_epi8(idx, idx));
+    return _mm256_add_epi8(v, _mm256_and_si256(mask, delta));
+}
+
+CIPHERSUITE_TARGET_AVX2 inline std::size_t shiftLettersAvx2(const char* in, char* out, const std::size_t n, const int shift) noexcept{
+    const __m256i s = _mm256_set1_epi8(static_cast<char>(shift));
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), shiftAvx2(v, s));
+    }
+    return i;
+}
+
+CIPHERSUITE_TARGET_AVX2 inline std::size_t shiftLettersStreamAvx2(const char* in, char* out, const std::size_t n, const unsigned char* stream, const std::size_t period, std::size_t& phase) noexcept{
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stream + phase));
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), shiftAvx2(v, s));
+        phase += 32;
+        if (phase >= period) {
+            phase -= period;
+        }
+    }
+    return i;
+}
+
+CIPHERSUITE_TARGET_AVX2 inline std::size_t reverseLettersAvx2(const char* in, char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), reverseAvx2(v));
+    }
+    return i;
+}
+
+CIPHERSUITE_TARGET_AVX2 inline std::size_t letterIndicesAvx2(const char* in, unsigned char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i mask;
+        const __m256i idx = letterIndexAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(idx, _mm256_andnot_si256(mask, _mm256_set1_epi8(-1))));
+    }
+    return i;
+}
+#endif
+
+#if defined(CIPHERSUITE_SIMD_AVX2)
+using ShuffleTable = std::array<std::array<unsigned char, 16>, 256>;
+
+/**
+ * A1Z26 encoding of 8 bytes laid out as pairs (tens, ones-or-byte): for
+ * each letter bit of the mask keep both bytes of its pair, otherwise only
+ * the second; unused lanes are zeroed
+ */
+inline constexpr ShuffleTable A1Z26_EXPAND = [] {
+    ShuffleTable table{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        std::size_t k = 0;
+        for (unsigned j = 0; j < 8; ++j) {
+            if (mask >> j & 1) {
+                table[mask][k++] = static_cast<unsigned char>(2 * j);
+            }
+            table[mask][k++] = static_cast<unsigned char>(2 * j + 1);
+        }
+        while (k < 16) {
+            table[mask][k++] = 0x80;
+        }
+    }
+    return table;
+}();
+
+/**
+ * Moves the bytes selected by the mask to the front of 8 lanes
+ */
+inline constexpr ShuffleTable COMPACT_BYTES = [] {
+    ShuffleTable table{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        std::size_t k = 0;
+        for (unsigned j = 0; j < 8; ++j) {
+            if (mask >> j & 1) {
+                table[mask][k++] = static_cast<unsigned char>(j);
+            }
+        }
+        while (k < 16) {
+            table[mask][k++] = 0x80;
+        }
+    }
+    return table;
+}();
+
+/**
+ * Zero-padded two-digit positions of the letter lanes of v (other lanes
+ * are garbage) and the letter mask
+ */
+CIPHERSUITE_TARGET_AVX2 inline void letterDigitsSse2(const __m128i v, __m128i& letters, __m128i& tens, __m128i& ones, __m128i& ge10) noexcept{
+    const __m128i index = _mm_add_epi8(letterIndexSse2(v, letters), _mm_set1_epi8(1));
+    ge10 = _mm_cmpgt_epi8(index, _mm_set1_epi8(9));
+    const __m128i ge20 = _mm_cmpgt_epi8(index, _mm_set1_epi8(19));
+    tens = _mm_add_epi8(_mm_sub_epi8(_mm_setzero_si128(), _mm_add_epi8(ge10, ge20)), _mm_set1_epi8('0'));
+    ones = _mm_add_epi8(_mm_sub_epi8(index, _mm_add_epi8(_mm_and_si128(ge10, _mm_set1_epi8(10)), _mm_and_si128(ge20, _mm_set1_epi8(10)))), _mm_set1_epi8('0'));
+}
+
+CIPHERSUITE_TARGET_AVX2 inline std::size_t countLettersAvx2(const char* in, const std::size_t n, std::size_t& letters) noexcept{
+    std::size_t i = 0;
+    std::size_t count = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i mask;
+        letterIndexAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), mask);
+        count += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(mask))));
+    }
+    letters = count;
+    return i;
+}
+
+/**
+ * Zero-padded two-digit positions for letters, digits moved up by 48,
+ * everything else copied; 16 input bytes per step
+ */
+CIPHERSUITE_TARGET_AVX2 inline std::size_t encodeA1z26Avx2(const char* in, const std::size_t n, char* out, const std::size_t capacity, std::size_t& written) noexcept{
+    std::size_t i = 0;
+    std::size_t o = 0;
+    for (; i + 16 <= n and o + 32 <= capacity; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i letters, tens, ones, ge10;
+        letterDigitsSse2(v, letters, tens, ones, ge10);
+        const __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+        const __m128i other = _mm_add_epi8(v, _mm_and_si128(digits, _mm_set1_epi8(48)));
+        const __m128i second = _mm_or_si128(_mm_and_si128(letters, ones), _mm_andnot_si128(letters, other));
+
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(letters));
+        const __m128i low = _mm_shuffle_epi8(_mm_unpacklo_epi8(tens, second), _mm_loadu_si128(reinterpret_cast<const __m128i*>(A1Z26_EXPAND[mask & 0xFF].data())));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), low);
+        o += 8 + static_cast<std::size_t>(std::popcount(mask & 0xFF));
+        const __m128i high = _mm_shuffle_epi8(_mm_unpackhi_epi8(tens, second), _mm_loadu_si128(reinterpret_cast<const __m128i*>(A1Z26_EXPAND[mask >> 8].data())));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), high);
+        o += 8 + static_cast<std::size_t>(std::popcount(mask >> 8));
+    }
+    written = o;
+    return i;
+}
+
+/**
+ * Expands a 16-bit lane mask to 0x00/0xFF bytes
+ */
+CIPHERSUITE_TARGET_AVX2 inline __m128i maskLanesSse2(const std::uint32_t mask) noexcept{
+    const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i bit = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    return _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(mask)), spread), bit), bit);
+}
+
+/**
+ * Stores the bytes of 16 selected by the mask back to back
+ * @return Bytes stored (the store itself always writes 16)
+ */
+CIPHERSUITE_TARGET_AVX2 inline std::size_t compactStoreSse2(const __m128i v, const unsigned mask, char* out) noexcept{
+    const __m128i low = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(COMPACT_BYTES[mask & 0xFF].data())));
+    const __m128i high = _mm_shuffle_epi8(_mm_srli_si128(v, 8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(COMPACT_BYTES[mask >> 8].data())));
+    const std::size_t first = static_cast<std::size_t>(std::popcount(mask & 0xFF));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), low);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + first), high);
+    return first + static_cast<std::size_t>(std::popcount(mask >> 8));
+}
+
+/**
+ * A1Z26 decoding, 16 input bytes per step, starting on a group boundary:
+ * a digit opens a group when it sits an even distance into its run of
+ * digits, and the group swallows the byte after it. Every lane yields a
+ * (first, second) byte pair plus a keep bit for each, and the kept bytes
+ * are compacted: group openers keep their letter, swallowed lanes keep
+ * nothing, letters keep one or two digits, anything else itself. The
+ * only state between blocks is whether the last lane's group swallows
+ * the next block's first byte.
+ * @tparam STORE false only counts the output bytes (out is unused)
+ */
+template<bool STORE>
+CIPHERSUITE_TARGET_AVX2 inline std::size_t decodeA1z26Avx2(const char* in, const std::size_t n, char* out, const std::size_t capacity, std::size_t& written) noexcept{
+    std::size_t i = 0;
+    std::size_t o = 0;
+    std::uint32_t swallowed = 0;
+    for (; i + 17 <= n and o + 32 <= capacity; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+        const __m128i next = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 1)), _mm_set1_epi8('0'));
+        const __m128i next_digit = _mm_cmpeq_epi8(_mm_min_epu8(next, _mm_set1_epi8(9)), next);
+
+        // Adding each run's start bit carries through runs that begin on
+        // an even lane and clears them; odd-lane runs are left standing
+        const std::uint32_t run = static_cast<std::uint32_t>(_mm_movemask_epi8(digits)) & ~swallowed;
+        const std::uint32_t run_starts = run & ~(run << 1);
+        const std::uint32_t odd_runs = run & (run + (run_starts & 0x5555));
+        const std::uint32_t starts = ((run & ~odd_runs) & 0x5555) | (odd_runs & 0xAAAA);
+        const __m128i opens = maskLanesSse2(starts);
+        const __m128i kept = maskLanesSse2(~((starts << 1) | swallowed) & 0xFFFF);
+        swallowed = starts >> 15;
+
+        const __m128i twice = _mm_add_epi8(digit, digit);
+        const __m128i eight = _mm_add_epi8(_mm_add_epi8(twice, twice), _mm_add_epi8(twice, twice));
+        const __m128i pair = _mm_add_epi8(_mm_add_epi8(eight, twice), next);
+        const __m128i value = _mm_or_si128(_mm_and_si128(next_digit, pair), _mm_andnot_si128(next_digit, digit));
+        const __m128i letter = _mm_add_epi8(value, _mm_set1_epi8('a' - 1));
+
+        __m128i letters, tens, ones, ge10;
+        letterDigitsSse2(v, letters, tens, ones, ge10);
+        const __m128i second = _mm_or_si128(_mm_and_si128(opens, letter),
+            _mm_andnot_si128(opens, _mm_or_si128(_mm_and_si128(letters, ones), _mm_andnot_si128(letters, v))));
+        const __m128i keep_first = _mm_and_si128(_mm_and_si128(letters, ge10), kept);
+
+        if constexpr (STORE) {
+            o += compactStoreSse2(_mm_unpacklo_epi8(tens, second), static_cast<unsigned>(_mm_movemask_epi8(_mm_unpacklo_epi8(keep_first, kept))), out + o);
+            o += compactStoreSse2(_mm_unpackhi_epi8(tens, second), static_cast<unsigned>(_mm_movemask_epi8(_mm_unpackhi_epi8(keep_first, kept))), out + o);
+        }
+        else {
+            o += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(kept))) + std::popcount(static_cast<unsigned>(_mm_movemask_epi8(keep_first))));
+        }
+    }
+    written = o;
+    // A group that opened on the last lane has already been emitted
+    return i + swallowed;
+}
+#endif
+
+#if defined(CIPHERSUITE_SIMD_NEON)
+inline uint8x16_t letterIndexNeon(const uint8x16_t v, uint8x16_t& mask) noexcept{
+    const uint8x16_t idx = vsubq_u8(vandq_u8(v, vdupq_n_u8(0xDF)), vdupq_n_u8('A'));
+    mask = vcleq_u8(idx, vdupq_n_u8(25));
+    return idx;
+}
+
+inline uint8x16_t shiftNeon(const uint8x16_t v, const uint8x16_t shift) noexcept{
+    uint8x16_t mask;
+    const uint8x16_t idx = letterIndexNeon(v, mask);
+    const uint8x16_t wrap = vcgtq_u8(vaddq_u8(idx, shift), vdupq_n_u8(25));
+    const uint8x16_t delta = vsubq_u8(shift, vandq_u8(wrap, vdupq_n_u8(26)));
+    return vaddq_u8(v, vandq_u8(mask, delta));
+}
+
+inline uint8x16_t reverseNeon(const uint8x16_t v) noexcept{
+    uint8x16_t mask;
+    const uint8x16_t idx = letterIndexNeon(v, mask);
+    const uint8x16_t delta = vsubq_u8(vdupq_n_u8(25), vaddq_u8(idx, idx));
+    return vaddq_u8(v, vandq_u8(mask, delta));
+}
+
+inline std::size_t shiftLettersNeon(const char* in, char* out, const std::size_t n, const int shift) noexcept{
+    const uint8x16_t s = vdupq_n_u8(static_cast<uint8_t>(shift));
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), shiftNeon(v, s));
+    }
+    return i;
+}
+
+inline std::size_t shiftLettersStreamNeon(const char* in, char* out, const std::size_t n, const unsigned char* stream, const std::size_t period, std::size_t& phase) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t s = vld1q_u8(stream + phase);
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), shiftNeon(v, s));
+        phase += 16;
+        if (phase >= period) {
+            phase -= period;
+        }
+    }
+    return i;
+}
+
+inline std::size_t reverseLettersNeon(const char* in, char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), reverseNeon(v));
+    }
+    return i;
+}
+
+inline std::size_t letterIndicesNeon(const char* in, unsigned char* out, const std::size_t n) noexcept{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t mask;
+        const uint8x16_t idx = letterIndexNeon(vld1q_u8(reinterpret_cast<const uint8_t*>(in + i)), mask);
+        vst1q_u8(out + i, vornq_u8(idx, mask));
+    }
+    return i;
+}
+#endif
+
+} // namespace simd
+
+/**
+ * Caesar kernel: shifts ASCII letters forward by shift, wrapping within
+ * their case. out may alias in.
+ * @param shift Normalized shift, 0..25
+ * @param level Instruction set to use; must be supported
+ * @return Number of leading bytes transformed (a multiple of the vector
+ *         width; 0 for SimdLevel::scalar)
+ */
+inline std::size_t shiftLetters(const std::span<const char> in, const std::span<char> out, const int shift, const SimdLevel level = bestSimdLevel()) noexcept{
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::shiftLettersAvx2(in.data(), out.data(), in.size(), shift);
+#endif
+#if defined(CIPHERSUITE_SIMD_X86)
+        case SimdLevel::sse2:
+            return simd::shiftLettersSse2(in.data(), out.data(), in.size(), shift);
+#endif
+#if defined(CIPHERSUITE_SIMD_NEON)
+        case SimdLevel::neon:
+            return simd::shiftLettersNeon(in.data(), out.data(), in.size(), shift);
+#endif
+        default:
+            (void)shift;
+            return 0;
+    }
+}
+
+/**
+ * Vigenère kernel: shifts each letter by the stream entry at its phase.
+ * @param stream Per-position shifts (0..25), readable for period + 31 bytes
+ * @param period Stream period, a multiple of the key length and >= 32
+ * @param phase Index into stream of in[0]; advanced past the bytes handled
+ * @return Number of leading bytes transformed, as for shiftLetters()
+ */
+inline std::size_t shiftLettersStream(const std::span<const char> in, const std::span<char> out, const unsigned char* stream, const std::size_t period, std::size_t& phase, const SimdLevel level = bestSimdLevel()) noexcept{
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::shiftLettersStreamAvx2(in.data(), out.data(), in.size(), stream, period, phase);
+#endif
+#if defined(CIPHERSUITE_SIMD_X86)
+        case SimdLevel::sse2:
+            return simd::shiftLettersStreamSse2(in.data(), out.data(), in.size(), stream, period, phase);
+#endif
+#if defined(CIPHERSUITE_SIMD_NEON)
+        case SimdLevel::neon:
+            return simd::shiftLettersStreamNeon(in.data(), out.data(), in.size(), stream, period, phase);
+#endif
+        default:
+            (void)stream;
+            (void)period;
+            (void)phase;
+            return 0;
+    }
+}
+
+/**
+ * Atbash kernel: mirrors ASCII letters within their case. out may alias in.
+ * @return Number of leading bytes transformed, as for shiftLetters()
+ */
+inline std::size_t reverseLetters(const std::span<const char> in, const std::span<char> out, const SimdLevel level = bestSimdLevel()) noexcept{
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::reverseLettersAvx2(in.data(), out.data(), in.size());
+#endif
+#if defined(CIPHERSUITE_SIMD_X86)
+        case SimdLevel::sse2:
+            return simd::reverseLettersSse2(in.data(), out.data(), in.size());
+#endif
+#if defined(CIPHERSUITE_SIMD_NEON)
+        case SimdLevel::neon:
+            return simd::reverseLettersNeon(in.data(), out.data(), in.size());
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Classification kernel for frequency analysis: writes each byte's letter
+ * index (0..25, case folded) or 0xFF for non-letters
+ * @param out At least in.size() bytes
+ * @return Number of leading bytes handled, as for shiftLetters()
+ */
+inline std::size_t letterIndices(const std::span<const char> in, unsigned char* const out, const SimdLevel level = bestSimdLevel()) noexcept{
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::letterIndicesAvx2(in.data(), out, in.size());
+#endif
+#if defined(CIPHERSUITE_SIMD_X86)
+        case SimdLevel::sse2:
+            return simd::letterIndicesSse2(in.data(), out, in.size());
+#endif
+#if defined(CIPHERSUITE_SIMD_NEON)
+        case SimdLevel::neon:
+            return simd::letterIndicesNeon(in.data(), out, in.size());
+#endif
+        default:
+            (void)out;
+            return 0;
+    }
+}
+
+/**
+ * A1Z26 encoding kernel: letters to zero-padded digit pairs, digits moved
+ * up by 48, other bytes copied
+ * @param written Set to the number of output bytes produced
+ * @return Number of leading input bytes handled, a multiple of 16 (0 on
+ *         levels without the kernel); never writes past out
+ */
+inline std::size_t encodeA1z26(const std::span<const char> in, const std::span<char> out, std::size_t& written, const SimdLevel level = bestSimdLevel()) noexcept{
+    written = 0;
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::encodeA1z26Avx2(in.data(), in.size(), out.data(), out.size(), written);
+#endif
+        default:
+            (void)in;
+            (void)out;
+            return 0;
+    }
+}
+
+/**
+ * A1Z26 decoding kernel: digit groups to letters, other bytes copied
+ * @param in Must start on a group boundary; the bytes handled end on one
+ * @param written Set to the number of output bytes produced
+ * @return Number of leading input bytes handled (0 on levels without the
+ *         kernel); never writes past out
+ */
+inline std::size_t decodeA1z26(const std::span<const char> in, const std::span<char> out, std::size_t& written, const SimdLevel level = bestSimdLevel()) noexcept{
+    written = 0;
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::decodeA1z26Avx2<true>(in.data(), in.size(), out.data(), out.size(), written);
+#endif
+        default:
+            (void)in;
+            (void)out;
+            return 0;
+    }
+}
+
+/**
+ * Output size of decodeA1z26() over in, without writing anything
+ * @param size Set to the output bytes of the leading bytes handled
+ * @return Number of leading input bytes handled, as for decodeA1z26()
+ */
+inline std::size_t measureA1z26Decode(const std::span<const char> in, std::size_t& size, const SimdLevel level = bestSimdLevel()) noexcept{
+    size = 0;
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::decodeA1z26Avx2<false>(in.data(), in.size(), nullptr, SIZE_MAX, size);
+#endif
+        default:
+            (void)in;
+            return 0;
+    }
+}
+
+/**
+ * Counts ASCII letters
+ * @param letters Set to the letters among the leading bytes handled
+ * @return Number of leading bytes handled, as for shiftLetters()
+ */
+inline std::size_t countLetters(const std::span<const char> in, std::size_t& letters, const SimdLevel level = bestSimdLevel()) noexcept{
+    letters = 0;
+    switch (level) {
+#if defined(CIPHERSUITE_SIMD_AVX2)
+        case SimdLevel::avx2:
+            return simd::countLettersAvx2(in.data(), in.size(), letters);
+#endif
+        default:
+            (void)in;
+            return 0;
+    }
+}
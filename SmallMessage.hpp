@@ -0,0 +1,252 @@
+/**
+ * @file SmallMessage.hpp
+ * @brief Latency Path for Short Messages on Stack Buffers
+ *
+ * IDs, tokens and other 8-64 byte messages spend more time in the general
+ * path (virtual call, size checks, SIMD dispatch, statistics, a
+ * std::string for the result) than in the cipher. SmallMessage<N> is a
+ * fixed-capacity buffer that lives on the stack, padded to whole 16-byte
+ * chunks, and SmallCipher transforms it a chunk at a time with one
+ * branch-free kernel: SSE2 on x86-64 (the Simd.hpp lane helpers), or SWAR
+ * on two 64-bit words elsewhere. Everything is inline, and no call
+ * allocates.
+ *
+ * SmallCipher covers every cipher with an AffineLetters form (see
+ * CipherPipeline.hpp): a letter x becomes s * x + b[i mod p], with
+ * s = +1 (Caesar, Vigenère) or -1 (Atbash), which SWAR evaluates on all
+ * eight bytes at once by masking out the non-letters.
+ *
+ * Features:
+ * - SmallMessage<N>: inline storage, N up to SMALL_MESSAGE_MAX bytes
+ * - Same output and stream-offset semantics as the regular ciphers
+ * - Not counted by Stats.hpp, deliberately: a timer would cost more
+ *   than the transform
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherPipeline.hpp"
+#include "Simd.hpp"
+#include "SubstitutionTable.hpp"
+#include<algorithm>
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<optional>
+#include<span>
+#include<stdexcept>
+#include<string_view>
+#include<vector>
+
+
+/**
+ * Largest SmallMessage capacity, and the piece size SmallCipher works in
+ */
+inline constexpr std::size_t SMALL_MESSAGE_MAX = 255;
+
+class SmallCipher;
+
+/**
+ * Message of up to N bytes stored inline, padded to whole chunks so
+ * SmallCipher never needs a partial tail
+ */
+template<std::size_t N>
+class SmallMessage {
+    static_assert(N > 0 and N <= SMALL_MESSAGE_MAX, "SmallMessage: capacity out of range");
+
+    public:
+        constexpr SmallMessage() noexcept = default;
+
+        /**
+         * @throws std::length_error if text is longer than N
+         */
+        explicit constexpr SmallMessage(const std::string_view text) {
+            if (text.size() > N) {
+                throw std::length_error("SmallMessage: text exceeds capacity");
+            }
+            std::copy(text.begin(), text.end(), bytes.begin());
+            length = static_cast<std::uint8_t>(text.size());
+        }
+
+        [[nodiscard]] static constexpr std::size_t capacity() noexcept{
+            return N;
+        }
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept{
+            return length;
+        }
+
+        [[nodiscard]] constexpr std::string_view view() const noexcept{
+            return {bytes.data(), length};
+        }
+
+        [[nodiscard]] constexpr std::span<char> span() noexcept{
+            return {bytes.data(), length};
+        }
+
+        [[nodiscard]] constexpr std::span<const char> span() const noexcept{
+            return {bytes.data(), length};
+        }
+
+        constexpr bool operator==(const SmallMessage& other) const noexcept{
+            return view() == other.view();
+        }
+
+    private:
+        friend class SmallCipher;
+
+        static constexpr std::size_t CHUNK = 16;
+        static constexpr std::size_t CHUNKS = (N + CHUNK - 1) / CHUNK;
+
+        std::array<char, CHUNKS * CHUNK> bytes{};
+        std::uint8_t length = 0;
+};
+
+class SmallCipher {
+    public:
+        /**
+         * Small-message form of cipher (Caesar, Atbash, Vigenère, or a
+         * pipeline that fused into one letter pass), or nullopt
+         */
+        [[nodiscard]] static std::optional<SmallCipher> of(const Encryption& cipher) {
+            const auto* const pipeline = dynamic_cast<const CipherPipeline*>(&cipher);
+            const std::optional<AffineLetters> form = pipeline != nullptr ? pipeline->fused() : AffineLetters::of(cipher);
+            if (not form) {
+                return std::nullopt;
+            }
+            return SmallCipher(*form);
+        }
+
+        explicit SmallCipher(const AffineLetters& form) : reflect(form.mirrored()), period(form.period()) {
+            // Any phase can read SMALL_MESSAGE_MAX shifts straight on
+            const std::span<const unsigned char> b = form.schedule();
+            encryptStream.resize(period + SMALL_MESSAGE_MAX + 16);
+            decryptStream.resize(encryptStream.size());
+            for (std::size_t i = 0; i < encryptStream.size(); ++i) {
+                encryptStream[i] = b[i % period];
+                decryptStream[i] = reflect ? b[i % period] : static_cast<unsigned char>((26 - b[i % period]) % 26);
+            }
+        }
+
+        /**
+         * Transforms in into out (at least as long, may alias in)
+         * @param offset Position of in[0] within the overall stream
+         */
+        void transform(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset = 0) const noexcept{
+            const unsigned char* const stream = d == Direction::encrypt ? encryptStream.data() : decryptStream.data();
+            for (std::size_t start = 0; start < in.size(); start += SMALL_MESSAGE_MAX) {
+                const std::size_t count = std::min(SMALL_MESSAGE_MAX, in.size() - start);
+                const std::size_t phase = period == 1 ? 0 : (offset + start) % period;
+                transformPiece(in.data() + start, out.data() + start, count, stream + phase);
+            }
+        }
+
+        /**
+         * Chunk loop over the padded storage: the trip count is bounded by
+         * N at compile time and there is no tail. Padding bytes are
+         * transformed too, which is harmless since they are never read.
+         */
+        template<std::size_t N>
+        void transformInPlace(SmallMessage<N>& message, const Direction d, const std::size_t offset = 0) const noexcept{
+            constexpr std::size_t CHUNK = SmallMessage<N>::CHUNK;
+            const unsigned char* const stream = (d == Direction::encrypt ? encryptStream.data() : decryptStream.data())
+                + (period == 1 ? 0 : offset % period);
+            const std::size_t chunks = (std::min(message.size(), N) + CHUNK - 1) / CHUNK;
+            for (std::size_t k = 0; k < chunks; ++k) {
+                transformChunk(message.bytes.data() + k * CHUNK, stream + k * CHUNK);
+            }
+        }
+
+        template<std::size_t N>
+        [[nodiscard]] SmallMessage<N> encrypt(SmallMessage<N> message, const std::size_t offset = 0) const noexcept{
+            transformInPlace(message, Direction::encrypt, offset);
+            return message;
+        }
+
+        template<std::size_t N>
+        [[nodiscard]] SmallMessage<N> decrypt(SmallMessage<N> message, const std::size_t offset = 0) const noexcept{
+            transformInPlace(message, Direction::decrypt, offset);
+            return message;
+        }
+
+    private:
+        static constexpr std::uint64_t ONES = 0x0101010101010101ull;
+
+        bool reflect;
+        std::size_t period;
+        // b (then 26 - b for decrypting a shift) repeated past the longest
+        // piece, so the shifts for a chunk are one unaligned load
+        std::vector<unsigned char> encryptStream;
+        std::vector<unsigned char> decryptStream;
+
+        /**
+         * Eight bytes at once: every letter index x becomes x + b, or b - x
+         * when mirrored, mod 26; everything else passes through
+         */
+        [[nodiscard]] std::uint64_t transformWord(const std::uint64_t w, const std::uint64_t shifts) const noexcept{
+            const std::uint64_t letters = letterBits(w) >> 7;          // 0x01 per letter
+            const std::uint64_t mask = letters * 0xFF;
+            const std::uint64_t index = (w & mask & (ONES * 0xDF)) - letters * 'A';
+            const std::uint64_t b = shifts & mask;
+            // 0..50 per byte either way, so no byte carries into the next
+            std::uint64_t t = reflect ? b + letters * 26 - index : index + b;
+            const std::uint64_t wrap = ((t + ONES * (128 - 26)) & (ONES * 0x80)) >> 7;   // 0x01 where t >= 26
+            t -= wrap * 26;
+            return (w & ~mask) | (t + letters * 'A') | (w & letters * 0x20);
+        }
+
+        /**
+         * 16 bytes in place
+         */
+        void transformChunk(char* const p, const unsigned char* const stream) const noexcept{
+#if defined(CIPHERSUITE_SIMD_X86)
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stream));
+            __m128i result;
+            if (reflect) {
+                // b - x, plus 26 where that went negative
+                __m128i mask;
+                const __m128i idx = simd::letterIndexSse2(v, mask);
+                __m128i t = _mm_sub_epi8(b, idx);
+                t = _mm_add_epi8(t, _mm_and_si128(_mm_cmpgt_epi8(_mm_setzero_si128(), t), _mm_set1_epi8(26)));
+                result = _mm_add_epi8(v, _mm_and_si128(mask, _mm_sub_epi8(t, idx)));
+            }
+            else {
+                result = simd::shiftSse2(v, b);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), result);
+#else
+            std::uint64_t w[2];
+            std::uint64_t shifts[2];
+            std::memcpy(w, p, sizeof w);
+            std::memcpy(shifts, stream, sizeof shifts);
+            w[0] = transformWord(w[0], shifts[0]);
+            w[1] = transformWord(w[1], shifts[1]);
+            std::memcpy(p, w, sizeof w);
+#endif
+        }
+
+        void transformPiece(const char* const in, char* const out, const std::size_t n, const unsigned char* const stream) const noexcept{
+            std::size_t i = 0;
+            std::uint64_t w;
+            std::uint64_t shifts;
+            for (; i + 8 <= n; i += 8) {
+                std::memcpy(&w, in + i, 8);
+                std::memcpy(&shifts, stream + i, 8);
+                w = transformWord(w, shifts);
+                std::memcpy(out + i, &w, 8);
+            }
+            if (i < n) {
+                // Zero bytes are not letters, so the padding stays zero
+                w = 0;
+                std::memcpy(&w, in + i, n - i);
+                std::memcpy(&shifts, stream + i, 8);
+                w = transformWord(w, shifts);
+                std::memcpy(out + i, &w, n - i);
+            }
+        }
+};
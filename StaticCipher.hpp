@@ -0,0 +1,141 @@
+/**
+ * @file StaticCipher.hpp
+ * @brief Compile-Time Cipher Specialization and Static Dispatch
+ *
+ * Two ways to skip the virtual call behind Encryption::transform():
+ *
+ * - CipherEngine<Spec> fixes the cipher and key in the type. Tables are
+ *   constants, every call inlines, and transforms are constexpr, so
+ *   fixed-key Caesar/Atbash can even run on string literals at compile
+ *   time:
+ *     constexpr auto secret = CipherEngine<FixedCaesar<3>>::apply("HELLO");
+ *
+ * - CipherVariant holds any of the four concrete ciphers by value;
+ *   visitTransform() dispatches once per call through std::visit and
+ *   then calls the final class's kernel directly.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "CipherFactory.hpp"
+#include "SubstitutionTable.hpp"
+#include<array>
+#include<cstddef>
+#include<optional>
+#include<span>
+#include<stdexcept>
+#include<string_view>
+#include<type_traits>
+#include<variant>
+
+
+/**
+ * Caesar with the shift fixed at compile time (normalized like setKey())
+ */
+template<int Key>
+struct FixedCaesar {
+    static constexpr int shift = ((Key % 26) + 26) % 26;
+
+    [[nodiscard]] static constexpr char encryptChar(const char c) noexcept{
+        return shiftLetter(c, shift);
+    }
+    [[nodiscard]] static constexpr char decryptChar(const char c) noexcept{
+        return shiftLetter(c, (26 - shift) % 26);
+    }
+    static std::size_t vectorKernel(const std::span<const char> in, const std::span<char> out, const Direction d) noexcept{
+        return shiftLetters(in, out, d == Direction::encrypt ? shift : (26 - shift) % 26);
+    }
+};
+
+struct FixedAtbash {
+    [[nodiscard]] static constexpr char encryptChar(const char c) noexcept{
+        return atbashChar(c);
+    }
+    [[nodiscard]] static constexpr char decryptChar(const char c) noexcept{
+        return atbashChar(c);
+    }
+    static std::size_t vectorKernel(const std::span<const char> in, const std::span<char> out, Direction) noexcept{
+        return reverseLetters(in, out);
+    }
+};
+
+/**
+ * Stateless, fully inlined engine for a fixed monoalphabetic cipher
+ * @tparam Spec FixedCaesar<K> or FixedAtbash
+ */
+template<typename Spec>
+class CipherEngine {
+    public:
+        static constexpr SubstitutionTable encryptTable = makeTable(Spec::encryptChar);
+        static constexpr SubstitutionTable decryptTable = makeTable(Spec::decryptChar);
+
+        [[nodiscard]] static constexpr char transformChar(const char c, const Direction d) noexcept{
+            const SubstitutionTable& table = d == Direction::encrypt ? encryptTable : decryptTable;
+            return static_cast<char>(table[static_cast<unsigned char>(c)]);
+        }
+
+        /**
+         * Transforms in into out (same size, may alias). Uses the SIMD
+         * kernel at run time and plain lookups in constant evaluation.
+         */
+        static constexpr void transform(const std::span<const char> in, const std::span<char> out, const Direction d = Direction::encrypt) noexcept{
+            std::size_t done = 0;
+            if (not std::is_constant_evaluated()) {
+                done = Spec::vectorKernel(in, out, d);
+            }
+            for (std::size_t i = done; i < in.size(); ++i) {
+                out[i] = transformChar(in[i], d);
+            }
+        }
+
+        /**
+         * Transforms a string literal, keeping its terminator
+         */
+        template<std::size_t N>
+        [[nodiscard]] static constexpr std::array<char, N> apply(const char (&text)[N], const Direction d = Direction::encrypt) noexcept{
+            std::array<char, N> result{};
+            for (std::size_t i = 0; i < N; ++i) {
+                result[i] = transformChar(text[i], d);
+            }
+            return result;
+        }
+};
+
+static_assert(std::string_view(CipherEngine<FixedCaesar<3>>::apply("Hello, Zebra!").data()) == "Khoor, Cheud!");
+static_assert(std::string_view(CipherEngine<FixedAtbash>::apply("HELLO").data()) == "SVOOL");
+
+using CipherVariant = std::variant<Caesar, Vigenere, A1Z26, Atbash>;
+
+/**
+ * Value-type counterpart of makeCipher()
+ * @return Configured cipher, or nullopt if the key is invalid
+ */
+[[nodiscard]] inline std::optional<CipherVariant> makeCipherVariant(const CipherId id, const std::string_view key) {
+    const auto cipher = makeCipher(id, key);
+    if (not cipher) {
+        return std::nullopt;
+    }
+    switch (id) {
+        case CipherId::caesar: return CipherVariant(static_cast<const Caesar&>(*cipher));
+        case CipherId::vigenere: return CipherVariant(static_cast<const Vigenere&>(*cipher));
+        case CipherId::a1z26: return CipherVariant(static_cast<const A1Z26&>(*cipher));
+        case CipherId::atbash: return CipherVariant(static_cast<const Atbash&>(*cipher));
+    }
+    return std::nullopt;
+}
+
+/**
+ * Encryption::transform() without the virtual call
+ * @throws std::length_error if out is too small
+ */
+inline std::size_t visitTransform(const CipherVariant& cipher, const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset = 0) {
+    return std::visit([&](const auto& c) {
+        if (out.size() < c.maxTransformedSize(in.size(), d) and out.size() < c.transformedSize(in, d)) {
+            throw std::length_error("visitTransform: output buffer too small");
+        }
+        return c.transformSpan(in, out, d, offset);
+    }, cipher);
+}
@@ -0,0 +1,392 @@
+/**
+ * @file Stats.hpp
+ * @brief Optional Hot-Path Instrumentation
+ *
+ * Counts, per cipher, the transform calls made, bytes in and out, time
+ * spent transforming and the owned outputs allocated, plus the time and
+ * bytes of the drivers' reads and writes. Snapshots export as JSON or
+ * Prometheus text (`cipher_suite --stats`).
+ *
+ * Compiled out by default: unless CIPHERSUITE_STATS is 1 (`make STATS=1`),
+ * the timers below are empty and every hook disappears. Enabled, a
+ * transform pays two steady_clock reads and a few relaxed atomic adds.
+ *
+ * Features:
+ * - Lock-free registry with one slot per cipher name
+ * - Only the outermost transform counts, so a pipeline's stages are
+ *   not counted twice
+ * - Process-wide heap allocation count for executables that install a
+ *   counting operator new (main.cpp does when enabled)
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<array>
+#include<atomic>
+#include<charconv>
+#include<chrono>
+#include<cstddef>
+#include<cstdint>
+#include<optional>
+#include<string>
+#include<string_view>
+#include<system_error>
+#include<utility>
+#include<vector>
+
+#ifndef CIPHERSUITE_STATS
+#define CIPHERSUITE_STATS 0
+#endif
+
+namespace stats {
+
+inline constexpr bool ENABLED = CIPHERSUITE_STATS != 0;
+
+enum class Format { json, prometheus };
+
+[[nodiscard]] inline std::optional<Format> parseFormat(const std::string_view name) noexcept{
+    if (name == "json") {
+        return Format::json;
+    }
+    if (name == "prometheus") {
+        return Format::prometheus;
+    }
+    return std::nullopt;
+}
+
+enum class IoOp { read, write };
+
+struct CipherSnapshot {
+    std::string name;
+    std::uint64_t calls = 0;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t transform_ns = 0;
+    std::uint64_t allocations = 0;
+};
+
+struct IoSnapshot {
+    std::uint64_t calls = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t ns = 0;
+};
+
+struct Snapshot {
+    std::vector<CipherSnapshot> ciphers;
+    IoSnapshot reads;
+    IoSnapshot writes;
+    std::uint64_t heap_allocations = 0;
+};
+
+/**
+ * Incremented by a counting operator new, if the executable has one
+ */
+inline std::atomic<std::uint64_t> heap_allocations{0};
+
+class Registry {
+    public:
+        struct Counters {
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> bytes_in{0};
+            std::atomic<std::uint64_t> bytes_out{0};
+            std::atomic<std::uint64_t> transform_ns{0};
+            std::atomic<std::uint64_t> allocations{0};
+        };
+
+        /**
+         * Counters for a cipher name, claimed on first use
+         * @param name Must outlive the registry (cipher names are literals)
+         */
+        [[nodiscard]] Counters& cipher(const std::string_view name) noexcept{
+            for (Slot& slot : slots) {
+                int state = slot.state.load(std::memory_order_acquire);
+                if (state == FREE) {
+                    if (slot.state.compare_exchange_strong(state, CLAIMING, std::memory_order_acq_rel)) {
+                        slot.name = name;
+                        slot.state.store(READY, std::memory_order_release);
+                        return slot.counters;
+                    }
+                }
+                // Another thread is naming this slot; it is almost never
+                // the one we want, but wait so names stay unique
+                while (state == CLAIMING) {
+                    state = slot.state.load(std::memory_order_acquire);
+                }
+                if (slot.name == name) {
+                    return slot.counters;
+                }
+            }
+            return other;
+        }
+
+        void recordIo(const IoOp op, const std::uint64_t bytes, const std::uint64_t ns) noexcept{
+            IoCounters& io = op == IoOp::read ? reads : writes;
+            io.calls.fetch_add(1, std::memory_order_relaxed);
+            io.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            io.ns.fetch_add(ns, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] Snapshot snapshot() const{
+            Snapshot result;
+            for (const Slot& slot : slots) {
+                if (slot.state.load(std::memory_order_acquire) == READY) {
+                    result.ciphers.push_back(read(slot.name, slot.counters));
+                }
+            }
+            if (other.calls.load(std::memory_order_relaxed) != 0) {
+                result.ciphers.push_back(read("other", other));
+            }
+            result.reads = read(reads);
+            result.writes = read(writes);
+            result.heap_allocations = heap_allocations.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        static constexpr std::size_t MAX_CIPHERS = 32;
+        static constexpr int FREE = 0;
+        static constexpr int CLAIMING = 1;
+        static constexpr int READY = 2;
+
+        struct Slot {
+            std::atomic<int> state{FREE};
+            std::string_view name;
+            Counters counters;
+        };
+
+        struct IoCounters {
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> bytes{0};
+            std::atomic<std::uint64_t> ns{0};
+        };
+
+        std::array<Slot, MAX_CIPHERS> slots;
+        Counters other;   // names beyond MAX_CIPHERS
+        IoCounters reads;
+        IoCounters writes;
+
+        [[nodiscard]] static CipherSnapshot read(const std::string_view name, const Counters& c) {
+            return {std::string(name), c.calls.load(std::memory_order_relaxed), c.bytes_in.load(std::memory_order_relaxed),
+                    c.bytes_out.load(std::memory_order_relaxed), c.transform_ns.load(std::memory_order_relaxed),
+                    c.allocations.load(std::memory_order_relaxed)};
+        }
+
+        [[nodiscard]] static IoSnapshot read(const IoCounters& c) noexcept{
+            return {c.calls.load(std::memory_order_relaxed), c.bytes.load(std::memory_order_relaxed), c.ns.load(std::memory_order_relaxed)};
+        }
+};
+
+[[nodiscard]] inline Registry& registry() noexcept{
+    static Registry instance;
+    return instance;
+}
+
+[[nodiscard]] inline std::uint64_t nanosecondsSince(const std::chrono::steady_clock::time_point start) noexcept{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+#if CIPHERSUITE_STATS
+
+/**
+ * Scope of one call into a cipher; nested calls (pipeline stages) are
+ * folded into the outermost one
+ */
+class TransformTimer {
+    public:
+        /**
+         * @param cipher Anything with a name() (an Encryption)
+         * @param bytes Input size of the call
+         */
+        template<typename Cipher>
+        TransformTimer(const Cipher& cipher, const std::size_t bytes) noexcept
+            : outermost(depth()++ == 0) {
+            if (outermost) {
+                counters = &registry().cipher(cipher.name());
+                counters->calls.fetch_add(1, std::memory_order_relaxed);
+                counters->bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        TransformTimer(const TransformTimer&) = delete;
+        TransformTimer& operator=(const TransformTimer&) = delete;
+
+        ~TransformTimer() {
+            --depth();
+            if (outermost) {
+                counters->transform_ns.fetch_add(nanosecondsSince(start), std::memory_order_relaxed);
+            }
+        }
+
+        void produced(const std::size_t bytes) noexcept{
+            if (outermost) {
+                counters->bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+
+        void allocated() noexcept{
+            if (outermost) {
+                counters->allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        bool outermost;
+        Registry::Counters* counters = nullptr;
+        std::chrono::steady_clock::time_point start;
+
+        static int& depth() noexcept{
+            thread_local int level = 0;
+            return level;
+        }
+};
+
+/**
+ * Times one read or write (or one wait for either) of a driver
+ */
+class IoTimer {
+    public:
+        IoTimer() noexcept : start(std::chrono::steady_clock::now()) {}
+
+        void record(const IoOp op, const std::size_t bytes) noexcept{
+            registry().recordIo(op, bytes, nanosecondsSince(start));
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+};
+
+#else
+
+class TransformTimer {
+    public:
+        template<typename Cipher>
+        TransformTimer(const Cipher&, std::size_t) noexcept{}
+        void produced(std::size_t) noexcept{}
+        void allocated() noexcept{}
+};
+
+class IoTimer {
+    public:
+        void record(IoOp, std::size_t) noexcept{}
+};
+
+#endif
+
+namespace detail {
+
+inline void appendNumber(std::string& out, const std::uint64_t value) {
+    out += std::to_string(value);
+}
+
+inline void appendSeconds(std::string& out, const std::uint64_t ns) {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(ns) / 1e9);
+    out.append(buffer, ec == std::errc{} ? end : buffer);
+}
+
+} // namespace detail
+
+/**
+ * {"ciphers":[{"name":...,"calls":...}], "io":{...}, "heap_allocations":N}
+ * with times in nanoseconds
+ */
+[[nodiscard]] inline std::string toJson(const Snapshot& snapshot) {
+    std::string out = "{\"ciphers\":[";
+    for (std::size_t i = 0; i < snapshot.ciphers.size(); ++i) {
+        const CipherSnapshot& c = snapshot.ciphers[i];
+        out += i == 0 ? "{" : ",{";
+        out += "\"name\":\"" + c.name + "\",\"calls\":";
+        detail::appendNumber(out, c.calls);
+        out += ",\"bytes_in\":";
+        detail::appendNumber(out, c.bytes_in);
+        out += ",\"bytes_out\":";
+        detail::appendNumber(out, c.bytes_out);
+        out += ",\"transform_ns\":";
+        detail::appendNumber(out, c.transform_ns);
+        out += ",\"allocations\":";
+        detail::appendNumber(out, c.allocations);
+        out += "}";
+    }
+    out += "],\"io\":{";
+    for (const auto& [name, io] : {std::pair{"read", snapshot.reads}, std::pair{"write", snapshot.writes}}) {
+        out += name == std::string_view("read") ? "\"" : ",\"";
+        out += name;
+        out += "\":{\"calls\":";
+        detail::appendNumber(out, io.calls);
+        out += ",\"bytes\":";
+        detail::appendNumber(out, io.bytes);
+        out += ",\"ns\":";
+        detail::appendNumber(out, io.ns);
+        out += "}";
+    }
+    out += "},\"heap_allocations\":";
+    detail::appendNumber(out, snapshot.heap_allocations);
+    out += "}\n";
+    return out;
+}
+
+/**
+ * Prometheus text exposition format, times in seconds
+ */
+[[nodiscard]] inline std::string toPrometheus(const Snapshot& snapshot) {
+    std::string out;
+    const auto family = [&](const std::string_view metric, const std::string_view help, auto value) {
+        out += "# HELP ciphersuite_";
+        out += metric;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ciphersuite_";
+        out += metric;
+        out += " counter\n";
+        for (const CipherSnapshot& c : snapshot.ciphers) {
+            out += "ciphersuite_";
+            out += metric;
+            out += "{cipher=\"" + c.name + "\"} ";
+            value(c);
+            out += '\n';
+        }
+    };
+    family("transform_calls_total", "Transform calls per cipher", [&](const CipherSnapshot& c) { detail::appendNumber(out, c.calls); });
+    family("input_bytes_total", "Bytes fed to each cipher", [&](const CipherSnapshot& c) { detail::appendNumber(out, c.bytes_in); });
+    family("output_bytes_total", "Bytes produced by each cipher", [&](const CipherSnapshot& c) { detail::appendNumber(out, c.bytes_out); });
+    family("transform_seconds_total", "Time spent transforming", [&](const CipherSnapshot& c) { detail::appendSeconds(out, c.transform_ns); });
+    family("allocations_total", "Owned outputs allocated", [&](const CipherSnapshot& c) { detail::appendNumber(out, c.allocations); });
+
+    const auto io = [&](const std::string_view metric, const std::string_view help, auto value) {
+        out += "# HELP ciphersuite_io_";
+        out += metric;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ciphersuite_io_";
+        out += metric;
+        out += " counter\n";
+        for (const auto& [name, counters] : {std::pair{"read", snapshot.reads}, std::pair{"write", snapshot.writes}}) {
+            out += "ciphersuite_io_";
+            out += metric;
+            out += "{op=\"";
+            out += name;
+            out += "\"} ";
+            value(counters);
+            out += '\n';
+        }
+    };
+    io("calls_total", "Driver reads and writes", [&](const IoSnapshot& s) { detail::appendNumber(out, s.calls); });
+    io("bytes_total", "Bytes read and written by the drivers", [&](const IoSnapshot& s) { detail::appendNumber(out, s.bytes); });
+    io("seconds_total", "Time spent reading and writing", [&](const IoSnapshot& s) { detail::appendSeconds(out, s.ns); });
+
+    out += "# HELP ciphersuite_heap_allocations_total Heap allocations by the process\n";
+    out += "# TYPE ciphersuite_heap_allocations_total counter\nciphersuite_heap_allocations_total ";
+    detail::appendNumber(out, snapshot.heap_allocations);
+    out += '\n';
+    return out;
+}
+
+[[nodiscard]] inline std::string format(const Snapshot& snapshot, const Format f) {
+    return f == Format::json ? toJson(snapshot) : toPrometheus(snapshot);
+}
+
+} // namespace stats
@@ -0,0 +1,238 @@
+/**
+ * @file Stream.hpp
+ * @brief Chunked Streaming Driver
+ *
+ * Pushes an input stream through a cipher in fixed-size chunks so memory
+ * use stays bounded regardless of input size. Works with any Encryption
+ * subclass through the span-based transform() and completeLength().
+ *
+ * IncrementalTransform is the resumable core: feed it fragments of any
+ * size as they arrive (network packets, reads) with update() and call
+ * finalize() at the end; the concatenated output is exactly what one
+ * transform() of the whole input would produce. streamTransform() is
+ * built on it.
+ *
+ * Features:
+ * - Constant memory: one input chunk plus one output chunk, both reused
+ * - Length-preserving ciphers transform the input chunk in place
+ * - Position tracking for position-dependent ciphers (Vigenère)
+ * - Carry-over of bytes that cannot be transformed without their
+ *   successor (A1Z26 digit pairs split across chunks)
+ * - Binary-safe: newlines and NUL bytes pass through untouched
+ * - Fragments as small as one byte
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include "Encryptions.hpp"
+#include "Parallel.hpp"
+#include<algorithm>
+#include<cstddef>
+#include<istream>
+#include<ostream>
+#include<span>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<vector>
+
+
+inline constexpr std::size_t DEFAULT_CHUNK_SIZE = std::size_t{1} << 16;
+
+/**
+ * Resumable transform of a stream delivered in fragments. Carries the
+ * stream position (Vigenère key phase) and the bytes that cannot be
+ * transformed before their successor arrives (the first digit of an
+ * A1Z26 pair) from one update() to the next.
+ *
+ * One object per stream; the cipher itself stays shared and untouched.
+ */
+class IncrementalTransform {
+    public:
+        /**
+         * @param engine Configured cipher; must outlive this object
+         * @param d Encrypt or decrypt
+         * @param offset Stream position of the first byte fed in
+         * @param workers When set, large fragments are split across these
+         *                threads
+         */
+        IncrementalTransform(const Encryption& engine, const Direction d, const std::size_t offset = 0, ThreadPool* const workers = nullptr) noexcept
+            : cipher(&engine), direction(d), position(offset), pool(workers) {}
+
+        /**
+         * Output buffer size that is always enough for update() on n bytes
+         * (or, with n = 0, for finalize())
+         */
+        [[nodiscard]] std::size_t maxOutputSize(const std::size_t n) const noexcept{
+            return cipher->maxTransformedSize(held.size() + n, direction);
+        }
+
+        /**
+         * Transforms as much of the stream so far as can be, and holds the
+         * rest back for the next call
+         * @param in Next fragment, of any size
+         * @param out At least maxOutputSize(in.size()) bytes; may alias in
+         *            for length-preserving ciphers while pending() is 0
+         * @return Number of bytes written to out
+         * @throws std::length_error if out is too small
+         */
+        std::size_t update(std::span<const char> in, const std::span<char> out) {
+            if (out.size() < maxOutputSize(in.size())) {
+                throw std::length_error("update: output buffer too small");
+            }
+            std::size_t written = 0;
+            if (not held.empty()) {
+                // Join the held bytes with just enough of the fragment to
+                // settle them, instead of copying the whole fragment
+                const std::size_t old = held.size();
+                const std::size_t taken = std::min(in.size(), JOIN_BYTES);
+                held.append(in.data(), taken);
+                std::size_t usable = cipher->completeLength(held, direction);
+                if (usable < old) {
+                    // The cipher needs more context than a few bytes
+                    held.append(in.data() + taken, in.size() - taken);
+                    usable = cipher->completeLength(held, direction);
+                    written = run({held.data(), usable}, out);
+                    held.erase(0, usable);
+                    return written;
+                }
+                written = run({held.data(), usable}, out);
+                in = in.subspan(usable - old);
+                held.clear();
+            }
+            const std::size_t usable = cipher->completeLength({in.data(), in.size()}, direction);
+            written += run(in.first(usable), out.subspan(written));
+            held.assign(in.data() + usable, in.size() - usable);
+            return written;
+        }
+
+        /**
+         * Transforms the held-back bytes as the end of the stream
+         * @param out At least maxOutputSize(0) bytes
+         * @return Number of bytes written to out
+         * @throws std::length_error if out is too small
+         */
+        std::size_t finalize(const std::span<char> out) {
+            if (out.size() < maxOutputSize(0)) {
+                throw std::length_error("finalize: output buffer too small");
+            }
+            const std::size_t written = run({held.data(), held.size()}, out);
+            held.clear();
+            return written;
+        }
+
+        /**
+         * update() into a new string
+         */
+        [[nodiscard]] std::string update(const std::string_view in) {
+            std::string out(maxOutputSize(in.size()), '\0');
+            out.resize(update(std::span<const char>(in), std::span<char>(out)));
+            return out;
+        }
+
+        /**
+         * finalize() into a new string
+         */
+        [[nodiscard]] std::string finalize() {
+            std::string out(maxOutputSize(0), '\0');
+            out.resize(finalize(std::span<char>(out)));
+            return out;
+        }
+
+        /**
+         * Stream position of the next byte to be transformed
+         */
+        [[nodiscard]] std::size_t offset() const noexcept{
+            return position;
+        }
+
+        /**
+         * Bytes received but held back
+         */
+        [[nodiscard]] std::size_t pending() const noexcept{
+            return held.size();
+        }
+
+        /**
+         * Starts a new stream, dropping any held-back bytes
+         */
+        void reset(const std::size_t offset = 0) noexcept{
+            held.clear();
+            position = offset;
+        }
+
+    private:
+        /**
+         * Bytes of a new fragment joined with held-back ones; A1Z26 needs
+         * one, the margin covers ciphers with wider groups
+         */
+        static constexpr std::size_t JOIN_BYTES = 64;
+
+        const Encryption* cipher;
+        Direction direction;
+        std::size_t position;
+        ThreadPool* pool;
+        std::string held;
+
+        std::size_t run(const std::span<const char> in, const std::span<char> out) {
+            const std::size_t written = pool != nullptr
+                ? parallelTransform(*cipher, in, out, direction, position, *pool)
+                : cipher->transform(in, out, direction, position);
+            position += in.size();
+            return written;
+        }
+};
+
+/**
+ * Transforms everything readable from in and writes it to out
+ * @param cipher Configured cipher
+ * @param d Encrypt or decrypt
+ * @param in Source stream, read until EOF
+ * @param out Destination stream
+ * @param chunk_size Bytes read per iteration (must be non-zero)
+ * @param pool When set, each chunk is split further across these threads
+ * @return false if reading or writing failed
+ */
+[[nodiscard]] inline bool streamTransform(const Encryption& cipher, const Direction d, std::istream& in, std::ostream& out, const std::size_t chunk_size = DEFAULT_CHUNK_SIZE, ThreadPool* const pool = nullptr) {
+    IncrementalTransform stream(cipher, d, 0, pool);
+    std::vector<char> input(chunk_size);
+    std::vector<char> output;
+    for (bool last = false; not last;) {
+        stats::IoTimer read_timer;
+        in.read(input.data(), static_cast<std::streamsize>(chunk_size));
+        if (in.bad()) {
+            return false;
+        }
+        read_timer.record(stats::IoOp::read, static_cast<std::size_t>(in.gcount()));
+        last = in.eof();
+        const std::span<char> chunk(input.data(), static_cast<std::size_t>(in.gcount()));
+
+        // Length-preserving ciphers rewrite the chunk where it lies
+        std::span<const char> result = chunk;
+        if (cipher.preservesLength() and stream.pending() == 0) {
+            stream.update(chunk, chunk);
+        }
+        else {
+            output.resize(stream.maxOutputSize(chunk.size()));
+            result = {output.data(), stream.update(chunk, output)};
+        }
+        stats::IoTimer write_timer;
+        out.write(result.data(), static_cast<std::streamsize>(result.size()));
+        write_timer.record(stats::IoOp::write, result.size());
+        if (last) {
+            output.resize(stream.maxOutputSize(0));
+            const std::size_t tail = stream.finalize(output);
+            stats::IoTimer tail_timer;
+            out.write(output.data(), static_cast<std::streamsize>(tail));
+            tail_timer.record(stats::IoOp::write, tail);
+        }
+        if (not out) {
+            return false;
+        }
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
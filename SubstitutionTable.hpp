@@ -0,0 +1,126 @@
+/**
+ * @file SubstitutionTable.hpp
+ * @brief 256-Entry Byte Translation Tables
+ *
+ * Monoalphabetic ciphers (Caesar, Atbash) map every byte value to exactly
+ * one output byte, independent of position. Precomputing that mapping
+ * turns the per-byte work into a single table lookup with no branches
+ * and no locale-dependent ctype calls.
+ *
+ * Features:
+ * - constexpr table construction from any per-character function
+ * - ASCII-only letter classification (matches the "C" locale)
+ * - Branch-free apply loop, safe for in == out
+ * - Letter-only tables skip 8-byte words with no ASCII letter (UTF-8
+ *   text in other scripts, digits, punctuation) as whole words
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<span>
+
+
+using SubstitutionTable = std::array<unsigned char, 256>;
+
+[[nodiscard]] constexpr bool isUpperAscii(const char c) noexcept{
+    return c >= 'A' and c <= 'Z';
+}
+
+[[nodiscard]] constexpr bool isLowerAscii(const char c) noexcept{
+    return c >= 'a' and c <= 'z';
+}
+
+[[nodiscard]] constexpr bool isDigitAscii(const char c) noexcept{
+    return c >= '0' and c <= '9';
+}
+
+/**
+ * Shifts an ASCII letter forward within its case; other bytes unchanged
+ * @param shift Normalized shift, 0..25
+ */
+[[nodiscard]] constexpr char shiftLetter(const char c, const int shift) noexcept{
+    if (isUpperAscii(c)) {
+        return (c - 'A' + shift) % 26 + 'A';
+    }
+    else if (isLowerAscii(c)) {
+        return (c - 'a' + shift) % 26 + 'a';
+    }
+    return c;
+}
+
+/**
+ * Tabulates f over every byte value
+ * @param f Callable char -> char
+ */
+template<typename F>
+[[nodiscard]] constexpr SubstitutionTable makeTable(F f) noexcept{
+    SubstitutionTable table{};
+    for (std::size_t b = 0; b < table.size(); ++b) {
+        table[b] = static_cast<unsigned char>(f(static_cast<char>(b)));
+    }
+    return table;
+}
+
+/**
+ * Translates in through table into out (out may alias in)
+ */
+inline void applyTable(const SubstitutionTable& table, const std::span<const char> in, const std::span<char> out) noexcept{
+    const auto* src = reinterpret_cast<const unsigned char*>(in.data());
+    auto* dst = reinterpret_cast<unsigned char*>(out.data());
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        dst[i] = table[src[i]];
+    }
+}
+
+/**
+ * High bit set in every byte of the 8-byte word w that is an ASCII
+ * letter: case is folded away, then every byte below 0x80 is tested for
+ * 0x40 < b < 0x5B at once (bytes with the high bit set never match)
+ */
+[[nodiscard]] constexpr std::uint64_t letterBits(const std::uint64_t w) noexcept{
+    constexpr std::uint64_t ONES = 0x0101010101010101ull;
+    const std::uint64_t folded = w & (ONES * 0xDF);
+    const std::uint64_t low = folded & (ONES * 0x7F);
+    return (ONES * (127 + 0x5B) - low) & ~folded & (low + ONES * (127 - 0x40)) & (ONES * 0x80);
+}
+
+[[nodiscard]] constexpr bool hasLetterWord(const std::uint64_t w) noexcept{
+    return letterBits(w) != 0;
+}
+
+/**
+ * applyTable() for tables that leave every non-letter unchanged (Caesar,
+ * Atbash and their compositions): 32-byte blocks without letters are
+ * copied whole, or left alone when out aliases in; blocks with letters
+ * keep the plain lookup loop
+ */
+inline void applyLetterTable(const SubstitutionTable& table, const std::span<const char> in, const std::span<char> out) noexcept{
+    constexpr std::size_t BLOCK = 32;
+    const auto* src = reinterpret_cast<const unsigned char*>(in.data());
+    auto* dst = reinterpret_cast<unsigned char*>(out.data());
+    const std::size_t n = in.size();
+    std::size_t i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        std::uint64_t w[BLOCK / 8];
+        std::memcpy(w, src + i, BLOCK);
+        if ((letterBits(w[0]) | letterBits(w[1]) | letterBits(w[2]) | letterBits(w[3])) == 0) {
+            if (dst != src) {
+                std::memcpy(dst + i, w, BLOCK);
+            }
+            continue;
+        }
+        for (std::size_t k = i; k < i + BLOCK; ++k) {
+            dst[k] = table[src[k]];
+        }
+    }
+    for (; i < n; ++i) {
+        dst[i] = table[src[i]];
+    }
+}
@@ -0,0 +1,172 @@
+/**
+ * @file ThreadPool.hpp
+ * @brief Fixed-Size Worker Pool
+ *
+ * Small pool of long-lived worker threads shared by the parallel drivers.
+ * parallelFor() lets the calling thread take part in the work, so it
+ * never waits on a queue it could drain itself and nested use from
+ * inside a task cannot deadlock.
+ *
+ * Features:
+ * - Fire-and-forget submit() for independent tasks
+ * - Blocking parallelFor() over an index range with dynamic balancing
+ * - Process-wide sharedThreadPool() sized to the hardware
+ * - RAII shutdown: the destructor drains the queue and joins
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<utility>
+#include<vector>
+
+
+class ThreadPool {
+    public:
+        /**
+         * @param workers Number of worker threads; 0 runs everything on
+         *                the submitting thread
+         */
+        explicit ThreadPool(const unsigned workers) {
+            threads.reserve(workers);
+            for (unsigned i = 0; i < workers; ++i) {
+                threads.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                const std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : threads) {
+                t.join();
+            }
+        }
+
+        [[nodiscard]] unsigned workerCount() const noexcept{
+            return static_cast<unsigned>(threads.size());
+        }
+
+        /**
+         * Total threads parallelFor() can use: the workers plus the caller
+         */
+        [[nodiscard]] unsigned concurrency() const noexcept{
+            return workerCount() + 1;
+        }
+
+        /**
+         * Queues a task for a worker; runs it inline when there are none
+         */
+        void submit(std::function<void()> task) {
+            if (threads.empty()) {
+                task();
+                return;
+            }
+            {
+                const std::lock_guard lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+
+        /**
+         * Calls f(i) for every i in [0, count) across the pool and the
+         * calling thread, returning once all calls have finished
+         * @param f Must not throw
+         */
+        template<typename F>
+        void parallelFor(const std::size_t count, F&& f) {
+            if (count == 0) {
+                return;
+            }
+            if (count == 1 or threads.empty()) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    f(i);
+                }
+                return;
+            }
+
+            // Helpers may start after the work is gone, so the shared
+            // state outlives this call
+            struct State {
+                std::atomic<std::size_t> next{0};
+                std::atomic<std::size_t> remaining;
+                std::mutex mutex;
+                std::condition_variable done;
+                explicit State(const std::size_t n) : remaining(n) {}
+            };
+            const auto state = std::make_shared<State>(count);
+            const auto run = [state, count, &f] {
+                for (std::size_t i; (i = state->next.fetch_add(1)) < count;) {
+                    f(i);
+                    if (state->remaining.fetch_sub(1) == 1) {
+                        const std::lock_guard lock(state->mutex);
+                        state->done.notify_all();
+                    }
+                }
+            };
+
+            const std::size_t helpers = std::min<std::size_t>(count - 1, threads.size());
+            for (std::size_t h = 0; h < helpers; ++h) {
+                submit(run);
+            }
+            run();
+            std::unique_lock lock(state->mutex);
+            state->done.wait(lock, [&] { return state->remaining.load() == 0; });
+        }
+
+    private:
+        std::vector<std::thread> threads;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        void workerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock(mutex);
+                    wake.wait(lock, [this] { return stopping or not tasks.empty(); });
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+};
+
+/**
+ * Number of hardware threads, never less than one
+ */
+[[nodiscard]] inline unsigned hardwareThreads() noexcept{
+    const unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * Process-wide pool with one worker per hardware thread besides the caller
+ */
+[[nodiscard]] inline ThreadPool& sharedThreadPool() {
+    static ThreadPool pool(hardwareThreads() - 1);
+    return pool;
+}
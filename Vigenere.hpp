@@ -9,7 +9,8 @@
  * Algorithm:
  * - Encryption: E(x_i) = (x_i + k_i) mod 26
  * - Decryption: D(x_i) = (x_i - k_i) mod 26
- * Where k_i is the i-th character of the keyword
+ * Where k_i is the i-th character of the keyword (A=1 ... Z=26,
+ * non-letters 0) and i counts every byte, letter or not
  * 
  * Security: Historical cipher, vulnerable to frequency analysis
  * Use Case: Educational purposes, basic polyalphabetic concepts
@@ -19,7 +20,10 @@
  * - Automatic key repetition for long messages
  * - Case-preserving operations
  * - Non-alphabetic character preservation
- * - Efficient key indexing with modulo arithmetic
+ * - Key schedule precomputed once per keyword: no per-byte modulo or
+ *   ctype calls, just a rolling index into a repeated shift stream
+ * - SIMD kernel applying the shift stream a vector at a time
+ * - Scalar path steps over 8-byte words with no letters in one go
  * 
  * @author CipherSuite Team
  * @version 1.0
@@ -28,56 +32,99 @@
 
 #pragma once
 #include "Encryptions.hpp"
+#include "SubstitutionTable.hpp"
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<span>
+#include<string>
+#include<utility>
+#include<vector>
 
 
 class Vigenere final: public Encryption {
     public:
-        void setMessage(std::string m) noexcept{
-            message = std::move(m);
+        [[nodiscard]] std::string_view name() const noexcept override{
+            return "vigenere";
         }
-        void setKeyMessage(std::string n) noexcept{
+
+        /**
+         * Sets the keyword and precomputes its shift streams
+         * An empty keyword leaves text unchanged
+         */
+        void setKeyMessage(std::string n) {
             messageKey = std::move(n);
+            buildKeyStreams();
+        }
+
+        [[nodiscard]] const std::string& getKeyMessage() const noexcept{
+            return messageKey;
+        }
+
+        /**
+         * Encryption shift (0..25) of each keyword character, one entry per
+         * character; empty for an empty keyword
+         */
+        [[nodiscard]] std::span<const unsigned char> keyShifts() const noexcept{
+            return std::span<const unsigned char>(encryptStream).first(period == 0 ? 0 : messageKey.size());
         }
 
-        void encrypt() override{
-            encrypted_message.clear();
-            for (int i = 0; const char c : message) {
-                if (std::isalpha(c)) {
-                    encrypted_message += encryptChar(c, i);
+        [[nodiscard]] bool positionIndependent() const noexcept override{
+            return false;
+        }
+
+        std::size_t transformSpan(const std::span<const char> in, const std::span<char> out, const Direction d, const std::size_t offset) const noexcept override{
+            if (period == 0) {
+                if (in.data() != out.data()) {
+                    std::copy(in.begin(), in.end(), out.begin());
+                }
+                return in.size();
+            }
+            const unsigned char* const stream = d == Direction::encrypt ? encryptStream.data() : decryptStream.data();
+            std::size_t phase = offset % period;
+            std::size_t i = shiftLettersStream(in, out, stream, period, phase, simd_level);
+            // Words without letters only advance the phase
+            for (; i + 8 <= in.size(); i += 8) {
+                std::uint64_t w;
+                std::memcpy(&w, in.data() + i, sizeof(w));
+                if (not hasLetterWord(w)) {
+                    if (out.data() != in.data()) {
+                        std::memcpy(out.data() + i, &w, sizeof(w));
+                    }
+                    phase += 8;
+                    if (phase >= period) {
+                        phase -= period;
+                    }
+                    continue;
                 }
-                else {
-                    encrypted_message += c;
+                for (std::size_t k = i; k < i + 8; ++k) {
+                    out[k] = shiftLetter(in[k], stream[phase]);
+                    if (++phase == period) {
+                        phase = 0;
+                    }
                 }
-                ++i;
             }
-        }
-
-        void decrypt() override{
-            encrypted_message.clear();
-            for (int keyIndex = 0; const char c : message) {
-                if (std::isalpha(c)) {
-                    encrypted_message += decryptChar(c, keyIndex);
-                } 
-                else {
-                    encrypted_message += c; 
+            for (; i < in.size(); ++i) {
+                out[i] = shiftLetter(in[i], stream[phase]);
+                if (++phase == period) {
+                    phase = 0;
                 }
-                ++keyIndex;
             }
+            return in.size();
         }
 
     private:
+        /**
+         * Shift streams span a whole number of keywords and at least one
+         * cache line, plus room for an unaligned vector load at the end
+         */
+        static constexpr std::size_t MIN_STREAM_PERIOD = 64;
+        static constexpr std::size_t STREAM_PADDING = 32;
+
         std::string messageKey;
-        // todo clean up
-        [[nodiscard]] char encryptChar(const char c, const int i) const noexcept{
-            const size_t size = messageKey.size();
-            if (std::isupper(c)) {
-                return c - 'A' + encryptKeyChar(messageKey[i % size]) + 'A';
-            } 
-            else if (std::islower(c)) {
-                return c - 'a' + encryptKeyChar(messageKey[i % size]) + 'a';
-            }
-            return c;
-        }
+        std::vector<unsigned char> encryptStream;
+        std::vector<unsigned char> decryptStream;
+        std::size_t period = 0;
 
         /**
          * Converts a character from the keyword to its shift value
@@ -87,10 +134,10 @@ class Vigenere final: public Encryption {
          */
         [[nodiscard]] static int encryptKeyChar(const char c) noexcept{
             
-            if (std::isupper(c)) {
+            if (isUpperAscii(c)) {
                 return c - 65 + 1; // A=65 in ASCII, convert to 1-based index
             } 
-            else if (std::islower(c)) {
+            else if (isLowerAscii(c)) {
                 return c - 97 + 1; // a=97 in ASCII, convert to 1-based index
             }
             else {
@@ -98,16 +145,21 @@ class Vigenere final: public Encryption {
             }
         }
 
-        [[nodiscard]] char decryptChar(const char c, const int k) const noexcept{
-            const char letter = messageKey[k % messageKey.size()];
-            const int shift = (std::isupper(letter) ? (letter - 'A') : (letter - 'a')) + 1;
-            if (std::isupper(c)) {
-                return (c - 'A' - shift + 26) % 26 + 'A';
-            } 
-            else if (std::islower(c)) {
-                return (c - 'a' - shift + 26) % 26 + 'a';
+        /**
+         * Expands the keyword into encrypt/decrypt shift streams (0..25)
+         * of length period + STREAM_PADDING, so encrypt and decrypt share
+         * one definition of the shift
+         */
+        void buildKeyStreams() {
+            const std::size_t size = messageKey.size();
+            period = size == 0 ? 0 : size * ((MIN_STREAM_PERIOD + size - 1) / size);
+            encryptStream.resize(period == 0 ? 0 : period + STREAM_PADDING);
+            decryptStream.resize(encryptStream.size());
+            for (std::size_t i = 0; i < encryptStream.size(); ++i) {
+                const int shift = encryptKeyChar(messageKey[i % size]) % 26;
+                encryptStream[i] = static_cast<unsigned char>(shift);
+                decryptStream[i] = static_cast<unsigned char>((26 - shift) % 26);
             }
-            return c;
         }
 
 };
\ No newline at end of file
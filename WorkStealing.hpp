@@ -0,0 +1,163 @@
+/**
+ * @file WorkStealing.hpp
+ * @brief Work-Stealing Task Scheduler
+ *
+ * Runs a set of tasks that may spawn further tasks, on a fixed number of
+ * threads, until all of them are done. Every thread owns a deque: it
+ * pushes and pops work at the back, so the pieces of a job it just split
+ * stay on the core that touched the data, while idle threads steal
+ * from the front of another thread's deque, taking the oldest and usually
+ * largest work first.
+ *
+ * Features:
+ * - spawn() from inside a task lands on the running thread's own deque
+ * - Threads park on a condition variable when every deque is empty and
+ *   wake as soon as new work appears
+ * - run() returns once the last task, spawned ones included, has finished
+ * - Steal counter for judging how uneven the work was
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#pragma once
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<utility>
+#include<vector>
+
+
+class WorkStealingPool {
+    public:
+        using Task = std::function<void()>;
+
+        /**
+         * @param threads Threads run() uses, the caller included (at least 1)
+         */
+        explicit WorkStealingPool(const unsigned threads) : queues(std::max(threads, 1u)) {}
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        [[nodiscard]] unsigned concurrency() const noexcept{
+            return static_cast<unsigned>(queues.size());
+        }
+
+        /**
+         * Queues a task. Called from one of this pool's tasks it goes to the
+         * running thread's deque, otherwise the deques take turns.
+         * @param task Must not throw
+         */
+        void spawn(Task task) {
+            const std::size_t queue = current_pool == this ? current_queue : next_queue++ % queues.size();
+            pending.fetch_add(1);
+            {
+                const std::lock_guard lock(queues[queue].mutex);
+                queues[queue].tasks.push_back(std::move(task));
+            }
+            queued.fetch_add(1);
+            {
+                const std::lock_guard lock(idle_mutex);
+            }
+            idle.notify_one();
+        }
+
+        /**
+         * Runs every queued task, and everything they spawn, on concurrency()
+         * threads (the calling thread is one of them) and returns when none
+         * is left
+         */
+        void run() {
+            std::vector<std::thread> helpers;
+            helpers.reserve(queues.size() - 1);
+            for (std::size_t q = 1; q < queues.size(); ++q) {
+                helpers.emplace_back([this, q] { work(q); });
+            }
+            work(0);
+            for (std::thread& t : helpers) {
+                t.join();
+            }
+        }
+
+        /**
+         * Tasks taken from another thread's deque so far
+         */
+        [[nodiscard]] std::size_t steals() const noexcept{
+            return steal_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<Queue> queues;
+        std::atomic<std::size_t> pending{0};   // queued or running
+        std::atomic<std::size_t> queued{0};    // sitting in a deque
+        std::atomic<std::size_t> steal_count{0};
+        std::size_t next_queue = 0;
+        std::mutex idle_mutex;
+        std::condition_variable idle;
+
+        inline static thread_local WorkStealingPool* current_pool = nullptr;
+        inline static thread_local std::size_t current_queue = 0;
+
+        bool take(const std::size_t q, const bool back, Task& task) {
+            Queue& queue = queues[q];
+            const std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                return false;
+            }
+            if (back) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            queued.fetch_sub(1);
+            return true;
+        }
+
+        bool steal(const std::size_t self, Task& task) {
+            for (std::size_t k = 1; k < queues.size(); ++k) {
+                if (take((self + k) % queues.size(), false, task)) {
+                    steal_count.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void work(const std::size_t self) {
+            WorkStealingPool* const outer_pool = std::exchange(current_pool, this);
+            const std::size_t outer_queue = std::exchange(current_queue, self);
+            for (;;) {
+                Task task;
+                if (take(self, true, task) or steal(self, task)) {
+                    task();
+                    if (pending.fetch_sub(1) == 1) {
+                        const std::lock_guard lock(idle_mutex);
+                        idle.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock lock(idle_mutex);
+                idle.wait(lock, [this] { return queued.load() > 0 or pending.load() == 0; });
+                if (pending.load() == 0) {
+                    break;
+                }
+            }
+            current_pool = outer_pool;
+            current_queue = outer_queue;
+        }
+};
@@ -0,0 +1,518 @@
+/**
+ * @file benchmarks.cpp
+ * @brief Throughput Benchmarks for Every Cipher
+ *
+ * Google Benchmark suite behind `make bench`. Measures encrypt and
+ * decrypt throughput for Caesar, Vigenère, A1Z26 and Atbash across input
+ * sizes from 16 B to BENCH_MAX_BYTES (1 GiB by default), on all-letter,
+ * mixed-punctuation and mostly non-Latin UTF-8 text, for several Vigenère key lengths, and for
+ * the scalar engine against the best SIMD level. Each result reports
+ * bytes/second and heap allocations per iteration.
+ *
+ * Benchmark names:
+ *   span/<cipher>/<dir>/<data>/<engine>/<bytes>   transform() into a
+ *                                                 preallocated buffer
+ *   owned/<cipher>/<dir>/<data>/<bytes>           encrypt()/decrypt()
+ *                                                 returning a new string
+ *   scratch/<cipher>/<dir>/<data>/<bytes>         applyScratch() into the
+ *                                                 thread-local buffer
+ *   arena/<cipher>/<dir>/<data>/<bytes>           pmr encrypt()/decrypt()
+ *                                                 from a per-request arena
+ *   vigenere_key/<key length>/<bytes>             key length sweep
+ *   setup/<cipher>/<construct|cache>              per-request cipher setup
+ *                                                 plus a 64-byte transform
+ *   pipeline/<fused|staged>/<bytes>               atbash,caesar:3,vigenere:SECRET
+ *                                                 as one CipherPipeline or
+ *                                                 as three in-place passes
+ *   server/<requests per call>                    64-byte Caesar round trips
+ *                                                 to CipherServer over a
+ *                                                 Unix socket, pipelined
+ *   small/<cipher>/<small|span|owned>/<bytes>     one short token per call
+ *                                                 through SmallCipher, the
+ *                                                 virtual span path or
+ *                                                 encrypt() to a string,
+ *                                                 with p50/p99 latency
+ *   offload/<cipher>/<dir>/<auto|device>/<bytes>  OffloadCipher with the
+ *                                                 default CPU threshold or
+ *                                                 none (only registered
+ *                                                 when an OpenCL device is
+ *                                                 present)
+ *
+ * Usage:
+ *   make bench
+ *   make bench BENCH_FILTER='span/caesar' BENCH_MAX_BYTES=16777216
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#include<benchmark/benchmark.h>
+#include<algorithm>
+#include<array>
+#include<atomic>
+#include<chrono>
+#include<cstddef>
+#include<cstdint>
+#include<cstdlib>
+#include<memory>
+#include<memory_resource>
+#include<new>
+#include<random>
+#include<string>
+#include<string_view>
+#include<thread>
+#include<vector>
+#include "CipherCache.hpp"
+#include "CipherPipeline.hpp"
+#include "CipherFactory.hpp"
+#include "Offload.hpp"
+#include "Server.hpp"
+#include "SmallMessage.hpp"
+
+#ifndef BENCH_MAX_BYTES
+#define BENCH_MAX_BYTES (std::int64_t{1} << 30)
+#endif
+
+// =============================================================================
+// Allocation counting
+// =============================================================================
+
+namespace {
+std::atomic<std::int64_t> allocations{0};
+}
+
+void* operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC flags free() on a pointer it traced back to operator new once
+// enough is inlined, though the operator new above got it from malloc()
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// =============================================================================
+// Input data
+// =============================================================================
+
+enum class DataKind { alpha, mixed, utf8 };
+
+constexpr std::string_view dataName(const DataKind kind) noexcept{
+    return kind == DataKind::alpha ? "alpha" : kind == DataKind::mixed ? "mixed" : "utf8";
+}
+
+/**
+ * Cyrillic words (two-byte UTF-8) with punctuation, one word in twenty
+ * in Latin script, as in mixed-script corpora
+ */
+std::string makeUtf8Pattern(std::mt19937& rng, const std::size_t n) {
+    std::string text;
+    text.reserve(n + 32);
+    while (text.size() < n) {
+        const bool latin = rng() % 20 == 0;
+        for (std::size_t length = 2 + rng() % 8; length > 0; --length) {
+            if (latin) {
+                text += static_cast<char>('a' + rng() % 26);
+            }
+            else {
+                const unsigned letter = 0x430 + rng() % 32;   // а..я
+                text += static_cast<char>(0xC0 | letter >> 6);
+                text += static_cast<char>(0x80 | (letter & 0x3F));
+            }
+        }
+        text += rng() % 8 == 0 ? ", " : " ";
+    }
+    text.resize(n);
+    return text;
+}
+
+/**
+ * n bytes of text, tiled from a 64 KiB random pattern so multi-GB inputs
+ * are cheap to build
+ */
+std::string makeInput(const DataKind kind, const std::size_t n) {
+    static constexpr std::string_view letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static constexpr std::string_view mixed = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUV    ,.;:!?'\"-()0123456789\n";
+    const std::string_view alphabet = kind == DataKind::alpha ? letters : mixed;
+
+    std::mt19937 rng(42);
+    std::string pattern(std::size_t{1} << 16, '\0');
+    if (kind == DataKind::utf8) {
+        pattern = makeUtf8Pattern(rng, pattern.size());
+    }
+    else {
+        for (char& c : pattern) {
+            c = alphabet[rng() % alphabet.size()];
+        }
+    }
+    std::string input(n, '\0');
+    for (std::size_t i = 0; i < n; i += pattern.size()) {
+        input.replace(i, std::min(pattern.size(), n - i), pattern, 0, std::min(pattern.size(), n - i));
+    }
+    return input;
+}
+
+/**
+ * Input for a benchmark run; decryption benchmarks get ciphertext so
+ * A1Z26 sees digit groups rather than letters
+ */
+std::string makeCipherInput(const Encryption& cipher, const Direction d, const DataKind kind, const std::size_t n) {
+    std::string input = makeInput(kind, n);
+    if (d == Direction::encrypt) {
+        return input;
+    }
+    std::string encrypted(cipher.transformedSize(input, Direction::encrypt), '\0');
+    cipher.transform(input, encrypted, Direction::encrypt);
+    encrypted.resize(n);
+    return encrypted;
+}
+
+struct CipherCase {
+    std::string_view name;
+    CipherId id;
+    std::string_view key;
+};
+
+constexpr CipherCase CIPHERS[] = {
+    {"caesar", CipherId::caesar, "3"},
+    {"vigenere", CipherId::vigenere, "SECRET"},
+    {"a1z26", CipherId::a1z26, ""},
+    {"atbash", CipherId::atbash, ""},
+};
+
+constexpr std::string_view directionName(const Direction d) noexcept{
+    return d == Direction::encrypt ? "encrypt" : "decrypt";
+}
+
+void reportCounters(benchmark::State& state, const std::size_t bytes, const std::int64_t allocs) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+    state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+void spanTransform(benchmark::State& state, const CipherCase& c, const Direction d, const DataKind kind, const SimdLevel level) {
+    const auto cipher = makeCipher(c.id, c.key);
+    cipher->setSimdLevel(level);
+    const std::string input = makeCipherInput(*cipher, d, kind, static_cast<std::size_t>(state.range(0)));
+    std::vector<char> output(cipher->maxTransformedSize(input.size(), d));
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cipher->transform(input, output, d));
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+void ownedTransform(benchmark::State& state, const CipherCase& c, const Direction d, const DataKind kind, const bool scratch) {
+    const auto cipher = makeCipher(c.id, c.key);
+    const std::string input = makeCipherInput(*cipher, d, kind, static_cast<std::size_t>(state.range(0)));
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        if (scratch) {
+            benchmark::DoNotOptimize(cipher->applyScratch(input, d).data());
+        }
+        else {
+            benchmark::DoNotOptimize(cipher->apply(input, d).data());
+        }
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+/**
+ * Owned outputs from a per-request monotonic arena over a reused buffer;
+ * the general-purpose allocator is never called
+ */
+void arenaTransform(benchmark::State& state, const CipherCase& c, const Direction d, const DataKind kind) {
+    const auto cipher = makeCipher(c.id, c.key);
+    const std::string input = makeCipherInput(*cipher, d, kind, static_cast<std::size_t>(state.range(0)));
+    std::vector<std::byte> buffer(cipher->maxTransformedSize(input.size(), d) + 64);
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+        benchmark::DoNotOptimize(cipher->apply(input, d, arena).data());
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+void vigenereKeyLength(benchmark::State& state) {
+    const std::string key(static_cast<std::size_t>(state.range(0)), 'K');
+    const auto cipher = makeCipher(CipherId::vigenere, key);
+    const std::string input = makeInput(DataKind::mixed, static_cast<std::size_t>(state.range(1)));
+    std::vector<char> output(input.size());
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cipher->transform(input, output, Direction::encrypt));
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+/**
+ * One request of a multi-tenant service: obtain the tenant's cipher, then
+ * encrypt a short message with it
+ */
+void perRequestSetup(benchmark::State& state, const CipherCase& c, const bool cached) {
+    CipherCache cache;
+    const std::string input = makeInput(DataKind::mixed, 64);
+    std::vector<char> output(input.size());
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        if (cached) {
+            const auto cipher = cache.get(c.id, c.key);
+            benchmark::DoNotOptimize(cipher->transform(input, output, Direction::encrypt));
+        }
+        else {
+            const auto cipher = makeCipher(c.id, c.key);
+            benchmark::DoNotOptimize(cipher->transform(input, output, Direction::encrypt));
+        }
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+/**
+ * Three-stage obfuscation chain, fused into one pass or run stage by stage
+ */
+void pipelineTransform(benchmark::State& state, const bool fused) {
+    constexpr std::string_view SPEC = "atbash,caesar:3,vigenere:SECRET";
+    const auto pipeline = parsePipeline(SPEC);
+    const std::vector<std::shared_ptr<const Encryption>> stages = {
+        makeCipher(CipherId::atbash, ""), makeCipher(CipherId::caesar, "3"), makeCipher(CipherId::vigenere, "SECRET"),
+    };
+    const std::string input = makeInput(DataKind::mixed, static_cast<std::size_t>(state.range(0)));
+    std::vector<char> output(input.size());
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        if (fused) {
+            benchmark::DoNotOptimize(pipeline->transform(input, output, Direction::encrypt));
+        }
+        else {
+            stages[0]->transform(input, output, Direction::encrypt);
+            stages[1]->transformInPlace(output, Direction::encrypt);
+            stages[2]->transformInPlace(output, Direction::encrypt);
+        }
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+enum class SmallPath { small, span, owned };
+
+constexpr std::string_view smallPathName(const SmallPath path) noexcept{
+    return path == SmallPath::small ? "small" : path == SmallPath::span ? "span" : "owned";
+}
+
+/**
+ * Per-call latency of encrypting one token. A clock read costs more than
+ * the call, so each iteration times a batch of LATENCY_BATCH calls on
+ * distinct tokens, and the batch means give the p50/p99 counters.
+ */
+void smallMessageLatency(benchmark::State& state, const CipherCase& c, const SmallPath path) {
+    constexpr std::size_t LATENCY_BATCH = 64;
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const auto cipher = makeCipher(c.id, c.key);
+    const std::optional<SmallCipher> small = SmallCipher::of(*cipher);
+    const std::string text = makeInput(DataKind::mixed, LATENCY_BATCH * n);
+    std::array<SmallMessage<64>, LATENCY_BATCH> tokens;
+    for (std::size_t k = 0; k < LATENCY_BATCH; ++k) {
+        tokens[k] = SmallMessage<64>(std::string_view(text).substr(k * n, n));
+    }
+    std::array<char, 64> output{};
+    std::vector<double> samples;
+    samples.reserve(std::size_t{1} << 20);
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        for (const SmallMessage<64>& token : tokens) {
+            if (path == SmallPath::small) {
+                benchmark::DoNotOptimize(small->encrypt(token));
+            }
+            else if (path == SmallPath::span) {
+                benchmark::DoNotOptimize(cipher->transform(token.span(), output, Direction::encrypt));
+            }
+            else {
+                benchmark::DoNotOptimize(cipher->encrypt(token.view()));
+            }
+            benchmark::ClobberMemory();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        if (samples.size() < samples.capacity()) {
+            samples.push_back(elapsed.count() / LATENCY_BATCH);
+        }
+    }
+    const std::int64_t allocs = allocations.load() - before;
+
+    const auto calls = static_cast<std::int64_t>(state.iterations() * LATENCY_BATCH);
+    state.SetItemsProcessed(calls);
+    state.SetBytesProcessed(calls * static_cast<std::int64_t>(n));
+    state.counters["allocs/call"] = static_cast<double>(allocs) / static_cast<double>(std::max<std::int64_t>(calls, 1));
+    if (not samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        state.counters["p50_ns"] = samples[samples.size() / 2];
+        state.counters["p99_ns"] = samples[samples.size() * 99 / 100];
+    }
+}
+
+/**
+ * Device transforms, including transfers; with forced every size goes to
+ * the device, showing where the default threshold sits against the CPU
+ */
+void offloadTransform(benchmark::State& state, const CipherCase& c, const Direction d, const bool forced) {
+    const std::shared_ptr<const Encryption> cpu = makeCipher(c.id, c.key);
+    const OffloadCipher cipher(cpu, forced ? 0 : OFFLOAD_MIN_BYTES);
+    const std::string input = makeCipherInput(*cpu, d, DataKind::mixed, static_cast<std::size_t>(state.range(0)));
+    std::vector<char> output(input.size());
+
+    const std::int64_t before = allocations.load();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cipher.transform(input, output, d));
+        benchmark::ClobberMemory();
+    }
+    reportCounters(state, input.size(), allocations.load() - before);
+}
+
+#if CIPHERSUITE_HAS_SERVER
+/**
+ * Round trips to an in-process server; requests per call are sent in
+ * one write, as a pipelining client would
+ */
+void serverRoundTrip(benchmark::State& state) {
+    const std::string address = "unix:/tmp/cipher_bench_" + std::to_string(::getpid()) + ".sock";
+    CipherServer server(openSocket(address, true), {.workers = 1});
+    std::thread loop([&] { server.run(); });
+    {
+        CipherClient client(address);
+        const std::string payload = makeInput(DataKind::mixed, 64);
+        const std::vector<ServerRequest> requests(static_cast<std::size_t>(state.range(0)),
+            ServerRequest{.cipher = CipherId::caesar, .key = "3", .payload = payload});
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(client.call(requests));
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0) * 64);
+    }
+    server.stop();
+    loop.join();
+    ::unlink(address.c_str() + 5);
+}
+#endif
+
+/**
+ * Engines worth comparing for a cipher: scalar, plus the best SIMD level
+ * for ciphers that have vector kernels there (A1Z26: AVX2 only)
+ */
+std::vector<SimdLevel> engines(const CipherId id) {
+    std::vector<SimdLevel> levels{SimdLevel::scalar};
+    if (bestSimdLevel() != SimdLevel::scalar and (id != CipherId::a1z26 or bestSimdLevel() == SimdLevel::avx2)) {
+        levels.push_back(bestSimdLevel());
+    }
+    return levels;
+}
+
+void registerBenchmarks() {
+    const std::int64_t max_bytes = BENCH_MAX_BYTES;
+    for (const CipherCase& c : CIPHERS) {
+        for (const Direction d : {Direction::encrypt, Direction::decrypt}) {
+            for (const DataKind kind : {DataKind::alpha, DataKind::mixed, DataKind::utf8}) {
+                const std::string suffix = std::string(c.name) + "/" + std::string(directionName(d)) + "/" + std::string(dataName(kind));
+                for (const SimdLevel level : engines(c.id)) {
+                    const std::string name = "span/" + suffix + "/" + std::string(simdLevelName(level));
+                    benchmark::RegisterBenchmark(name.c_str(), spanTransform, c, d, kind, level)
+                        ->RangeMultiplier(16)->Range(16, max_bytes);
+                }
+                if (kind == DataKind::utf8) {
+                    continue;
+                }
+                benchmark::RegisterBenchmark(("arena/" + suffix).c_str(), arenaTransform, c, d, kind)
+                    ->RangeMultiplier(16)->Range(16, std::min<std::int64_t>(max_bytes, 1 << 24));
+                for (const bool scratch : {false, true}) {
+                    benchmark::RegisterBenchmark(((scratch ? "scratch/" : "owned/") + suffix).c_str(), ownedTransform, c, d, kind, scratch)
+                        ->RangeMultiplier(16)->Range(16, std::min<std::int64_t>(max_bytes, 1 << 24));
+                }
+            }
+        }
+    }
+    for (const CipherCase& c : CIPHERS) {
+        if (needsKey(c.id)) {
+            benchmark::RegisterBenchmark(("setup/" + std::string(c.name) + "/construct").c_str(), perRequestSetup, c, false);
+            benchmark::RegisterBenchmark(("setup/" + std::string(c.name) + "/cache").c_str(), perRequestSetup, c, true);
+        }
+    }
+    for (const bool fused : {true, false}) {
+        benchmark::RegisterBenchmark(fused ? "pipeline/fused" : "pipeline/staged", pipelineTransform, fused)
+            ->RangeMultiplier(64)->Range(64, std::min<std::int64_t>(max_bytes, 1 << 26));
+    }
+    for (const CipherCase& c : CIPHERS) {
+        if (c.id == CipherId::a1z26) {
+            continue;
+        }
+        for (const SmallPath path : {SmallPath::small, SmallPath::span, SmallPath::owned}) {
+            const std::string name = "small/" + std::string(c.name) + "/" + std::string(smallPathName(path));
+            benchmark::RegisterBenchmark(name.c_str(), smallMessageLatency, c, path)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+        }
+    }
+    if (offloadDeviceName()) {
+        for (const CipherCase& c : CIPHERS) {
+            if (c.id == CipherId::a1z26) {
+                continue;
+            }
+            for (const Direction d : {Direction::encrypt, Direction::decrypt}) {
+                for (const bool forced : {false, true}) {
+                    const std::string name = "offload/" + std::string(c.name) + "/" + std::string(directionName(d)) + (forced ? "/device" : "/auto");
+                    benchmark::RegisterBenchmark(name.c_str(), offloadTransform, c, d, forced)
+                        ->RangeMultiplier(4)->Range(1 << 16, max_bytes)->UseRealTime();
+                }
+            }
+        }
+    }
+#if CIPHERSUITE_HAS_SERVER
+    benchmark::RegisterBenchmark("server", serverRoundTrip)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+#endif
+    for (const std::int64_t key_length : {1, 3, 8, 16, 64, 256}) {
+        benchmark::RegisterBenchmark("vigenere_key", vigenereKeyLength)
+            ->Args({key_length, std::min<std::int64_t>(max_bytes, 1 << 20)});
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    registerBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("simd_level", std::string(simdLevelName(bestSimdLevel())));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
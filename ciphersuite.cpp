@@ -0,0 +1,208 @@
+/**
+ * @file ciphersuite.cpp
+ * @brief libciphersuite: C Interface over the Header-Only Ciphers
+ *
+ * The only translation unit of the library. Contexts wrap a configured
+ * Encryption; every entry point validates its arguments and turns C++
+ * exceptions into status codes before returning to C.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "Batch.hpp"
+#include "CipherFactory.hpp"
+#include "CipherPipeline.hpp"
+#include "ciphersuite.h"
+#include<functional>
+#include<memory>
+#include<new>
+#include<span>
+#include<string_view>
+
+
+struct ciphersuite_cipher {
+    std::unique_ptr<Encryption> impl;
+};
+
+namespace {
+
+[[nodiscard]] bool validDirection(const ciphersuite_direction d) noexcept{
+    return d == CIPHERSUITE_ENCRYPT or d == CIPHERSUITE_DECRYPT;
+}
+
+[[nodiscard]] Direction toDirection(const ciphersuite_direction d) noexcept{
+    return d == CIPHERSUITE_ENCRYPT ? Direction::encrypt : Direction::decrypt;
+}
+
+/**
+ * True if [a, a + n) and [b, b + m) share a byte
+ */
+[[nodiscard]] bool overlaps(const char* a, const std::size_t n, const char* b, const std::size_t m) noexcept{
+    const std::less<const char*> before;
+    return n != 0 and m != 0 and before(a, b + m) and before(b, a + n);
+}
+
+/**
+ * Runs f, mapping anything it throws onto a status
+ */
+template<typename F>
+[[nodiscard]] ciphersuite_status guarded(F&& f) noexcept{
+    try {
+        return f();
+    }
+    catch (const std::bad_alloc&) {
+        return CIPHERSUITE_ERROR_OUT_OF_MEMORY;
+    }
+    catch (const std::length_error&) {
+        return CIPHERSUITE_ERROR_BUFFER_TOO_SMALL;
+    }
+    catch (...) {
+        return CIPHERSUITE_ERROR_INTERNAL;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t ciphersuite_abi_version(void) {
+    return CIPHERSUITE_ABI_VERSION;
+}
+
+const char* ciphersuite_status_string(const ciphersuite_status status) {
+    switch (status) {
+        case CIPHERSUITE_OK:
+            return "ok";
+        case CIPHERSUITE_ERROR_INVALID_ARGUMENT:
+            return "invalid argument";
+        case CIPHERSUITE_ERROR_UNKNOWN_CIPHER:
+            return "unknown cipher";
+        case CIPHERSUITE_ERROR_INVALID_KEY:
+            return "invalid key";
+        case CIPHERSUITE_ERROR_BUFFER_TOO_SMALL:
+            return "output buffer too small";
+        case CIPHERSUITE_ERROR_OUT_OF_MEMORY:
+            return "out of memory";
+        case CIPHERSUITE_ERROR_INTERNAL:
+            return "internal error";
+    }
+    return "unknown status";
+}
+
+ciphersuite_status ciphersuite_create(const char* const name, const char* const key, const size_t key_length, ciphersuite_cipher** const cipher) {
+    if (name == nullptr or cipher == nullptr or (key == nullptr and key_length != 0)) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+    *cipher = nullptr;
+    return guarded([&] {
+        const auto id = parseCipherId(name);
+        if (not id) {
+            return CIPHERSUITE_ERROR_UNKNOWN_CIPHER;
+        }
+        std::unique_ptr<Encryption> impl = makeCipher(*id, key == nullptr ? std::string_view() : std::string_view(key, key_length));
+        if (not impl) {
+            return CIPHERSUITE_ERROR_INVALID_KEY;
+        }
+        *cipher = new ciphersuite_cipher{std::move(impl)};
+        return CIPHERSUITE_OK;
+    });
+}
+
+ciphersuite_status ciphersuite_create_chain(const char* const spec, ciphersuite_cipher** const cipher) {
+    if (spec == nullptr or cipher == nullptr) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+    *cipher = nullptr;
+    return guarded([&] {
+        std::unique_ptr<Encryption> impl = parsePipeline(spec);
+        if (not impl) {
+            return CIPHERSUITE_ERROR_INVALID_KEY;
+        }
+        *cipher = new ciphersuite_cipher{std::move(impl)};
+        return CIPHERSUITE_OK;
+    });
+}
+
+void ciphersuite_destroy(ciphersuite_cipher* const cipher) {
+    delete cipher;
+}
+
+int ciphersuite_preserves_length(const ciphersuite_cipher* const cipher) {
+    return cipher != nullptr and cipher->impl->preservesLength();
+}
+
+size_t ciphersuite_max_output_size(const ciphersuite_cipher* const cipher, const size_t in_length, const ciphersuite_direction direction) {
+    if (cipher == nullptr or not validDirection(direction)) {
+        return 0;
+    }
+    return cipher->impl->maxTransformedSize(in_length, toDirection(direction));
+}
+
+ciphersuite_status ciphersuite_transform(const ciphersuite_cipher* const cipher, const ciphersuite_direction direction,
+    const char* const in, const size_t in_length, const size_t offset, char* const out, const size_t out_capacity, size_t* const written) {
+    if (cipher == nullptr or written == nullptr or not validDirection(direction)
+        or (in == nullptr and in_length != 0) or (out == nullptr and out_capacity != 0)) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+    *written = 0;
+    const Encryption& impl = *cipher->impl;
+    const bool in_place = in == out and impl.preservesLength();
+    if (not in_place and overlaps(in, in_length, out, out_capacity)) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+
+    const Direction d = toDirection(direction);
+    const std::span<const char> source(in, in_length);
+    if (out_capacity < impl.maxTransformedSize(in_length, d)) {
+        const std::size_t needed = impl.transformedSize(source, d, offset);
+        if (out_capacity < needed) {
+            *written = needed;
+            return CIPHERSUITE_ERROR_BUFFER_TOO_SMALL;
+        }
+    }
+    return guarded([&] {
+        if (in_place) {
+            impl.transformInPlace(std::span(out, in_length), d, offset);
+            *written = in_length;
+        }
+        else {
+            *written = impl.transform(source, std::span(out, out_capacity), d, offset);
+        }
+        return CIPHERSUITE_OK;
+    });
+}
+
+ciphersuite_status ciphersuite_transform_batch(const ciphersuite_cipher* const cipher, const ciphersuite_direction direction,
+    const char* const data, const size_t* const offsets, const size_t count, char* const out, const size_t out_capacity, size_t* const out_offsets, size_t* const written) {
+    if (cipher == nullptr or offsets == nullptr or out_offsets == nullptr or written == nullptr or not validDirection(direction)) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+    *written = 0;
+    if (offsets[0] != 0) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (offsets[i + 1] < offsets[i]) {
+            return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+        }
+    }
+    const std::size_t total = offsets[count];
+    if ((data == nullptr and total != 0) or (out == nullptr and out_capacity != 0) or overlaps(data, total, out, out_capacity)) {
+        return CIPHERSUITE_ERROR_INVALID_ARGUMENT;
+    }
+
+    const Direction d = toDirection(direction);
+    const std::size_t needed = cipher->impl->maxTransformedSize(total, d);
+    if (out_capacity < needed) {
+        *written = needed;
+        return CIPHERSUITE_ERROR_BUFFER_TOO_SMALL;
+    }
+    return guarded([&] {
+        *written = transformBatch(*cipher->impl, std::span(data, total), std::span(offsets, count + 1), std::span(out, out_capacity), std::span(out_offsets, count + 1), d);
+        return CIPHERSUITE_OK;
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,140 @@
+/**
+ * @file ciphersuite.h
+ * @brief C Interface of libciphersuite
+ *
+ * Stable C ABI over the span and batch APIs, for embedding the ciphers in
+ * C programs and in other languages through their C FFI (Python ctypes,
+ * cffi, ...). Callers own every buffer: nothing is copied or allocated
+ * per call, and data is transformed straight from in to out.
+ *
+ * Features:
+ * - Opaque, immutable cipher contexts; one context may be used from any
+ *   number of threads at once
+ * - Single-buffer transform, with a stream offset for Vigenère's key phase
+ * - In-place transform for length-preserving ciphers (in == out)
+ * - Packed-record batch transform (see Batch.hpp)
+ * - Status codes instead of exceptions; no C++ type crosses the boundary
+ *
+ * Link with -lciphersuite (plus -lstdc++ -pthread for the static
+ * library).
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#ifndef CIPHERSUITE_H
+#define CIPHERSUITE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(CIPHERSUITE_BUILDING_LIBRARY)
+#define CIPHERSUITE_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define CIPHERSUITE_API __attribute__((visibility("default")))
+#else
+#define CIPHERSUITE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Bumped whenever a declaration in this header changes incompatibly
+ */
+#define CIPHERSUITE_ABI_VERSION 1
+
+typedef struct ciphersuite_cipher ciphersuite_cipher;
+
+typedef enum ciphersuite_direction {
+    CIPHERSUITE_ENCRYPT = 0,
+    CIPHERSUITE_DECRYPT = 1
+} ciphersuite_direction;
+
+typedef enum ciphersuite_status {
+    CIPHERSUITE_OK = 0,
+    CIPHERSUITE_ERROR_INVALID_ARGUMENT = 1,  /* null pointer, bad direction, overlapping buffers */
+    CIPHERSUITE_ERROR_UNKNOWN_CIPHER = 2,
+    CIPHERSUITE_ERROR_INVALID_KEY = 3,
+    CIPHERSUITE_ERROR_BUFFER_TOO_SMALL = 4,  /* *written holds the size needed */
+    CIPHERSUITE_ERROR_OUT_OF_MEMORY = 5,
+    CIPHERSUITE_ERROR_INTERNAL = 6
+} ciphersuite_status;
+
+/**
+ * ABI version of the loaded library, to compare with CIPHERSUITE_ABI_VERSION
+ */
+CIPHERSUITE_API uint32_t ciphersuite_abi_version(void);
+
+/**
+ * Static, English description of a status code
+ */
+CIPHERSUITE_API const char* ciphersuite_status_string(ciphersuite_status status);
+
+/**
+ * Creates a cipher context
+ * @param name "caesar", "vigenere", "a1z26" or "atbash" (NUL-terminated)
+ * @param key Shift for caesar, keyword for vigenere, ignored (may be NULL)
+ *            otherwise; need not be NUL-terminated
+ * @param key_length Bytes of key
+ * @param cipher Receives the context, to be released with
+ *               ciphersuite_destroy()
+ */
+CIPHERSUITE_API ciphersuite_status ciphersuite_create(const char* name, const char* key, size_t key_length, ciphersuite_cipher** cipher);
+
+/**
+ * Creates a fused chain, e.g. "atbash,caesar:3,vigenere:SECRET"
+ * (decrypting undoes the stages in reverse order)
+ * @param spec NUL-terminated chain specification
+ * @param cipher Receives the context
+ */
+CIPHERSUITE_API ciphersuite_status ciphersuite_create_chain(const char* spec, ciphersuite_cipher** cipher);
+
+/**
+ * Releases a context; NULL is ignored
+ */
+CIPHERSUITE_API void ciphersuite_destroy(ciphersuite_cipher* cipher);
+
+/**
+ * Non-zero when output is always as long as input (in-place transforms
+ * are allowed)
+ */
+CIPHERSUITE_API int ciphersuite_preserves_length(const ciphersuite_cipher* cipher);
+
+/**
+ * Output capacity that is enough for any in_length bytes of input
+ */
+CIPHERSUITE_API size_t ciphersuite_max_output_size(const ciphersuite_cipher* cipher, size_t in_length, ciphersuite_direction direction);
+
+/**
+ * Transforms in[0, in_length) into out
+ * @param offset Position of in[0] within the overall message (0 for a
+ *               whole message); transforming consecutive pieces with
+ *               their offsets gives the same bytes as one call
+ * @param out Destination of out_capacity bytes; may equal in for
+ *            length-preserving ciphers, must not overlap it otherwise
+ * @param written Receives the bytes written, or the capacity needed when
+ *                the call fails with CIPHERSUITE_ERROR_BUFFER_TOO_SMALL
+ */
+CIPHERSUITE_API ciphersuite_status ciphersuite_transform(const ciphersuite_cipher* cipher, ciphersuite_direction direction,
+    const char* in, size_t in_length, size_t offset, char* out, size_t out_capacity, size_t* written);
+
+/**
+ * Transforms count packed records, each a message of its own
+ * (record i is data[offsets[i], offsets[i + 1]))
+ * @param offsets count + 1 ascending offsets into data, starting at 0
+ * @param out Destination arena of at least
+ *            ciphersuite_max_output_size(offsets[count]) bytes
+ * @param out_offsets Receives count + 1 offsets into out
+ * @param written Receives the total bytes written
+ */
+CIPHERSUITE_API ciphersuite_status ciphersuite_transform_batch(const ciphersuite_cipher* cipher, ciphersuite_direction direction,
+    const char* data, const size_t* offsets, size_t count, char* out, size_t out_capacity, size_t* out_offsets, size_t* written);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
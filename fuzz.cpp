@@ -0,0 +1,160 @@
+/**
+ * @file fuzz.cpp
+ * @brief Differential Fuzzing and Throughput Gate for the Optimized Engines
+ *
+ * Driver for Equivalence.hpp behind `make fuzz`, `make libfuzzer` and
+ * `make gate`. Every case runs through each engine (SIMD levels,
+ * streaming, parallel, ranges, batches, static, small-message, offload)
+ * and must match the naive reference byte for byte; the gate fails when
+ * a fast path is slower than the engine it replaces.
+ *
+ * Usage:
+ *   cipher_fuzz [--cases N] [--seed S]          N random cases (property run)
+ *   cipher_fuzz FILE...                          replay libFuzzer inputs
+ *   cipher_fuzz --gate [--min-speedup X] [--bytes N] [--repetitions N]
+ *
+ * Built with -DCIPHERSUITE_LIBFUZZER (make libfuzzer, needs clang++) the
+ * file provides LLVMFuzzerTestOneInput() instead of main(), and any
+ * mismatch aborts so libFuzzer saves the input.
+ *
+ * Exit status: 0 when everything matches (and the gate passes), 1 on a
+ * mismatch or a gate failure, 2 on bad arguments.
+ *
+ * @author CipherSuite Team
+ * @version 1.0
+ * @date 2024
+ */
+
+#include<cmath>
+#include<cstddef>
+#include<cstdint>
+#include<cstdio>
+#include<cstdlib>
+#include<fstream>
+#include<iterator>
+#include<print>
+#include<random>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "Cli.hpp"
+#include "Equivalence.hpp"
+
+/**
+ * Prints every mismatch of c
+ * @return Whether all engines agreed
+ */
+static bool report(const EquivalenceCase& c) {
+    const std::vector<Mismatch> mismatches = checkCase(c);
+    for (const Mismatch& m : mismatches) {
+        std::println(stderr, "❌ {} differs from the naive reference at byte {}: {}", m.engine, m.position, describeCase(c));
+    }
+    return mismatches.empty();
+}
+
+#if defined(CIPHERSUITE_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* const data, const std::size_t size) {
+    if (not report(caseFromBytes({data, size}))) {
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+static int runGate(const double min_speedup, const std::size_t bytes, const unsigned repetitions) {
+    std::println("⏱️  Throughput gate: {} bytes, best of {}, fast paths must reach {}x their baseline", bytes, repetitions, min_speedup);
+    bool passed = true;
+    for (const GateResult& result : throughputGate(bytes, repetitions)) {
+        const bool ok = result.speedup() >= min_speedup;
+        passed = passed and ok;
+        std::println("{} {}: {}x ({} MB/s -> {} MB/s)", ok ? "✅" : "❌", result.name, std::round(result.speedup() * 100) / 100,
+            std::round(bytes / result.baseline_seconds / 1e6), std::round(bytes / result.engine_seconds / 1e6));
+    }
+    return passed ? 0 : 1;
+}
+
+int main(const int argc, char** const argv) {
+    std::size_t cases = 1000;
+    std::uint64_t seed = 1;
+    bool gate = false;
+    double min_speedup = 1.0;
+    std::size_t bytes = GATE_BYTES;
+    unsigned repetitions = 5;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool valid = true;
+        if (arg == "--gate") {
+            gate = true;
+        }
+        else if (arg == "--cases" and has_value) {
+            const auto value = parseCount<std::size_t>(argv[++i]);
+            valid = value.has_value();
+            cases = value.value_or(0);
+        }
+        else if (arg == "--seed" and has_value) {
+            const auto value = parseCount<std::uint64_t>(argv[++i]);
+            valid = value.has_value();
+            seed = value.value_or(0);
+        }
+        else if (arg == "--min-speedup" and has_value) {
+            const auto value = parseCount<double>(argv[++i]);
+            valid = value.has_value();
+            min_speedup = value.value_or(0.0);
+        }
+        else if (arg == "--bytes" and has_value) {
+            const auto value = parseCount<std::size_t>(argv[++i]);
+            valid = value.has_value() and *value > 0;
+            bytes = value.value_or(0);
+        }
+        else if (arg == "--repetitions" and has_value) {
+            const auto value = parseCount<unsigned>(argv[++i]);
+            valid = value.has_value() and *value > 0;
+            repetitions = value.value_or(0);
+        }
+        else if (not arg.starts_with("--")) {
+            files.emplace_back(arg);
+        }
+        else {
+            valid = false;
+        }
+        if (not valid) {
+            std::println(stderr, "Usage: cipher_fuzz [--cases N] [--seed S] | FILE... | --gate [--min-speedup X] [--bytes N] [--repetitions N]");
+            return 2;
+        }
+    }
+
+    if (gate) {
+        return runGate(min_speedup, bytes, repetitions);
+    }
+
+    bool passed = true;
+    if (not files.empty()) {
+        for (const std::string& path : files) {
+            std::ifstream in(path, std::ios::binary);
+            if (not in) {
+                std::println(stderr, "❌ Cannot read {}", path);
+                return 2;
+            }
+            const std::vector<unsigned char> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+            passed = report(caseFromBytes(data)) and passed;
+        }
+        return passed ? 0 : 1;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < cases; ++i) {
+        if (not report(randomCase(rng))) {
+            ++failed;
+        }
+    }
+    std::println("{} {} of {} cases match the naive reference (seed {})", failed == 0 ? "✅" : "❌", cases - failed, cases, seed);
+    return failed == 0 ? 0 : 1;
+}
+
+#endif
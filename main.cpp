@@ -9,6 +9,7 @@
  * 
  * Features:
  * - Interactive command-line interface
+ * - Flag-driven streaming mode for scripts and pipes (see Cli.hpp)
  * - Input validation and error handling
  * - Support for both encryption and decryption
  * - Modern C++20 features (std::print, string_view, structured bindings)
@@ -23,11 +24,121 @@
 #include<print>
 #include<cctype>
 #include<string_view>
+#include<tuple>
 #include<utility>
 #include "A1Z26.hpp"
 #include "Caesar.hpp"
 #include "Atbash.hpp"
 #include "Vigenere.hpp"
+#include "Cli.hpp"
+
+#if CIPHERSUITE_STATS
+#include<cstdlib>
+#include<new>
+
+// Counts every heap allocation for --stats. Every replaceable form is
+// replaced, so no allocation bypasses the counter or meets a foreign free.
+// Once inlined, GCC pairs std::free() with the operator new at the call
+// site and reports a mismatch; both sides are malloc here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static void* countedAllocation(std::size_t size, const std::align_val_t alignment) noexcept{
+    stats::heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    const auto align = static_cast<std::size_t>(alignment);
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return std::malloc(size);
+    }
+    // aligned_alloc() takes whole multiples of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    if (void* p = countedAllocation(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size) {
+    return operator new(size, std::align_val_t{__STDCPP_DEFAULT_NEW_ALIGNMENT__});
+}
+
+void* operator new[](const std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept{
+    return countedAllocation(size, std::align_val_t{__STDCPP_DEFAULT_NEW_ALIGNMENT__});
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept{
+    return countedAllocation(size, std::align_val_t{__STDCPP_DEFAULT_NEW_ALIGNMENT__});
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept{
+    return countedAllocation(size, alignment);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept{
+    return countedAllocation(size, alignment);
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+#pragma GCC diagnostic pop
+#endif
 
 
 void printMenu() {
@@ -107,7 +218,10 @@ std::pair<bool, int> validInput(const std::string_view input) {
     return choice == "E";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runCli(argc, argv);
+    }
     printMenu();
     int input = getUserInput();
     switch(input) {
@@ -115,17 +229,15 @@ int main() {
             Caesar caesar;
             if (isEncrypt()) {
                 std::println("Enter the message you want to encrypt.");
-                caesar.setMessage(readInput());
+                const std::string message = readInput();
                 caesar.setKey(readKey());
-                caesar.encrypt();
-                std::cout << caesar.getEncryptedMessage() << '\n';
+                std::cout << caesar.encrypt(message) << '\n';
             }
             else {
                 std::println("Enter the message you want to decrypt.");
-                caesar.setMessage(readInput());
+                const std::string message = readInput();
                 caesar.setKey(readKey());
-                caesar.decrypt();
-                std::cout << caesar.getEncryptedMessage() << '\n';
+                std::cout << caesar.decrypt(message) << '\n';
             }
         }
             break;
@@ -133,51 +245,41 @@ int main() {
             Vigenere vigenere;
             if (isEncrypt()) {
                 std::println("Enter the message you want to encrypt.");
-                vigenere.setMessage(readInput());
+                const std::string message = readInput();
                 std::println("Enter the key message.");
                 vigenere.setKeyMessage(readInput());
-                vigenere.encrypt();
-                std::cout << vigenere.getEncryptedMessage() << '\n';
+                std::cout << vigenere.encrypt(message) << '\n';
             }
             else {
                 std::println("Enter the message you want to decrypt.");
-                vigenere.setMessage(readInput());
+                const std::string message = readInput();
                 std::println("Enter the key message.");
                 vigenere.setKeyMessage(readInput());
-                vigenere.decrypt();
-                std::cout << vigenere.getEncryptedMessage() << '\n';
+                std::cout << vigenere.decrypt(message) << '\n';
             }
         }
             break;
         case 3: {
-            A1Z26 a1z26;
+            const A1Z26 a1z26;
             if (isEncrypt()) {
                 std::println("Enter the message you want to encrypt.");
-                a1z26.setMessage(readInput());
-                a1z26.encrypt();
-                std::cout << a1z26.getEncryptedMessage() << '\n';
+                std::cout << a1z26.encrypt(readInput()) << '\n';
             }
             else {
                 std::println("Enter the message you want to decrypt.");
-                a1z26.setMessage(readInput());
-                a1z26.decrypt();
-                std::cout << a1z26.getEncryptedMessage() << '\n';
+                std::cout << a1z26.decrypt(readInput()) << '\n';
             }
         }
             break;
         case 4: {
-            Atbash atbash;
+            const Atbash atbash;
             if (isEncrypt()) {
                 std::println("Enter the message you want to encrypt.");
-                atbash.setMessage(readInput());
-                atbash.encrypt();
-                std::cout << atbash.getEncryptedMessage() << '\n';
+                std::cout << atbash.encrypt(readInput()) << '\n';
             }
             else {
                 std::println("Enter the message you want to decrypt.");
-                atbash.setMessage(readInput());
-                atbash.encrypt();
-                std::cout << atbash.getEncryptedMessage() << '\n';
+                std::cout << atbash.decrypt(readInput()) << '\n';
             }
         }
             break;